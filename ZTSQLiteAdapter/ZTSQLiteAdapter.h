@@ -15,8 +15,27 @@ FOUNDATION_EXPORT double ZTSQLiteAdapterVersionNumber;
 //! Project version string for ZTSQLiteAdapter.
 FOUNDATION_EXPORT const unsigned char ZTSQLiteAdapterVersionString[];
 
+#import <ZTSQLiteAdapter/ZTSQLiteBulkWriter.h>
+
 @protocol MTLModel;
 
+struct sqlite3_stmt;
+
+/// Determines when an adapter calls -validate: on the models it decodes.
+typedef NS_ENUM(NSInteger, ZTSQLiteValidationPolicy) {
+    /// Every decoded model is validated.
+    ZTSQLiteValidationPolicyAlways = 0,
+
+    /// Decoded models are only validated in Debug builds of ZTSQLiteAdapter.
+    ZTSQLiteValidationPolicyDebugOnly,
+
+    /// One of every +SQLiteValidationSamplingInterval decoded models is validated.
+    ZTSQLiteValidationPolicySampled,
+
+    /// Decoded models are never validated.
+    ZTSQLiteValidationPolicyNever,
+};
+
 @protocol ZTSQLiteSerializing <MTLModel>
 @required
 
@@ -43,6 +62,71 @@ FOUNDATION_EXPORT const unsigned char ZTSQLiteAdapterVersionString[];
 /// Returns a set of property keys.
 + (NSSet *)propertyKeysForPrimaryKeys;
 
+/// Specifies whether ZTSQLiteAdapter should track changes to decoded models.
+///
+/// If YES, the column values of every model decoded by ZTSQLiteAdapter are
+/// remembered, and UPDATE statements for that model only set the columns whose
+/// serialized values differ from them. Serializing doesn't change the remembered
+/// values; call +didPersistModel:error: after executing an UPDATE or upsert so
+/// that the next UPDATE compares against what was written. Models that were not
+/// decoded by ZTSQLiteAdapter, including copies of decoded models, are always
+/// fully updated.
+///
+/// Returns whether to track changes. Defaults to NO if not implemented.
++ (BOOL)tracksSQLiteChanges;
+
+/// Specifies whether ZTSQLiteAdapter should unique decoded models by primary key.
+///
+/// If YES, every adapter keeps a weak reference to each model it decodes, keyed
+/// by the model's primary key column values. Decoding a row whose model is
+/// still alive returns that same instance without running any transformers,
+/// as long as none of the row's column values changed since it was decoded
+/// or last passed to +didPersistModel:error:. Otherwise a new model is decoded and replaces the old one in the map.
+///
+/// Since decoded models are shared, they should not be mutated without
+/// synchronization. Models decoded with a subset of their properties are
+/// never shared. The receiver must implement +propertyKeysForPrimaryKeys.
+///
+/// Returns whether to use an identity map. Defaults to NO if not implemented.
++ (BOOL)usesSQLiteIdentityMap;
+
+/// Specifies when ZTSQLiteAdapter should call -validate: on decoded models.
+///
+/// Skipping validation is useful for rows the app wrote itself. Values are
+/// still validated one by one by MTLModel's -initWithDictionary:error:.
+/// Subclasses returned by +classForParsingResultDictionary: inherit the policy
+/// of the receiver unless they override this method.
+///
+/// Returns a validation policy. Defaults to ZTSQLiteValidationPolicyAlways if
+/// not implemented.
++ (ZTSQLiteValidationPolicy)SQLiteValidationPolicy;
+
+/// Specifies how many decoded models share one validation under
+/// ZTSQLiteValidationPolicySampled.
+///
+/// Returns a sampling interval. Defaults to 100 if not implemented.
++ (NSUInteger)SQLiteValidationSamplingInterval;
+
+/// Specifies property keys whose column values should be decoded on first access.
+///
+/// ZTSQLiteAdapter keeps the raw column values of these properties and only runs
+/// their value transformers when the property is first read. This is useful
+/// for expensive transformers, like ones unarchiving large blobs, of properties
+/// that are rarely read.
+///
+/// Lazily decoded models are instances of a private subclass of the receiver,
+/// which still reports the receiver as its class. Only object-typed properties
+/// with a value transformer are decoded lazily, and only if the receiver is a
+/// subclass of MTLModel that doesn't override -validate:. Lazy properties are
+/// validated when they are decoded. Since a getter can't report errors, a lazy
+/// property that fails to decode or validate is logged and stays nil. Setting a
+/// lazy property through its setter before reading it discards the column value,
+/// so the value set is kept and serialized. Setting its instance variable
+/// directly does not.
+///
+/// Returns a set of property keys.
++ (NSSet *)propertyKeysForLazySQLiteDecoding;
+
 /// Specifies how to convert a SQLite column value to the given property key. If
 /// reversible, the transformer will also be used to convert the property value
 /// back to a value used in a SQLite statement.
@@ -74,8 +158,101 @@ extern NSString * const ZTSQLiteAdapterErrorDomain;
 /// +classForParsingResultDictionary: returned nil for the given dictionary.
 extern const NSInteger ZTSQLiteAdapterErrorNoClassFound;
 
+/// Stepping or binding a SQLite statement failed.
+extern const NSInteger ZTSQLiteAdapterErrorStatementFailed;
+
+/// A row in a batch could not be deserialized, and no underlying error was given.
+extern const NSInteger ZTSQLiteAdapterErrorInvalidRow;
+
+/// A statement identifying a row by its primary key was serialized for a model
+/// that was decoded without its primary key columns.
+extern const NSInteger ZTSQLiteAdapterErrorPrimaryKeyNotDecoded;
+
+/// Returns an error with code ZTSQLiteAdapterErrorStatementFailed describing the
+/// last failure on a database connection.
+///
+/// database   - The database connection a call failed on. This argument must not be NULL.
+/// resultCode - The result code of the failed call, reported if SQLite has no message.
+extern NSError *ZTSQLiteAdapterStatementFailedError(struct sqlite3 *database, int resultCode);
+
+/// Returns an error with code ZTSQLiteAdapterErrorInvalidRow, for a row that
+/// could not be converted without an underlying error.
+extern NSError *ZTSQLiteAdapterInvalidRowError(void);
+
+#ifndef ZTSQLITE_INSTRUMENTATION
+/// Whether ZTSQLiteAdapter is built with instrumentation hooks. Define it as 0
+/// to compile them out. Hooks that are compiled in but not enabled cost one
+/// atomic load per instrumented phase.
+#define ZTSQLITE_INSTRUMENTATION 1
+#endif
+
+#if ZTSQLITE_INSTRUMENTATION
+
+/// The events reported by instrumented adapters.
+typedef NS_ENUM(NSUInteger, ZTSQLiteInstrumentationEvent) {
+    /// Running the value transformers of one decoded row. If the model is
+    /// created before its properties are set, this includes setting them. Timed.
+    ZTSQLiteInstrumentationEventDecodeTransform = 0,
+
+    /// Creating one decoded model, through +modelWithDictionary:error: or -init. Timed.
+    ZTSQLiteInstrumentationEventModelCreation,
+
+    /// Validating one decoded model, whether or not it turns out valid. Timed.
+    ZTSQLiteInstrumentationEventValidation,
+
+    /// Serializing property values of one model into parameters. Serializing
+    /// for an UPDATE reports the changed columns and the primary key separately. Timed.
+    ZTSQLiteInstrumentationEventEncodeTransform,
+
+    /// Generating a statement that was not cached yet. Timed.
+    ZTSQLiteInstrumentationEventStatementBuilding,
+
+    /// A value transformer failed while decoding or encoding.
+    ZTSQLiteInstrumentationEventTransformerFailure,
+
+    /// A model was handed to the adapter of a subclass, either because of
+    /// +classForParsingResultDictionary: or because it is an instance of a subclass.
+    ZTSQLiteInstrumentationEventClassClusterRedirect,
+};
+
+/// The number of buckets of a latency histogram.
+#define ZTSQLiteInstrumentationHistogramBucketCount 32
+
+/// The statistics of one event aggregated by an adapter.
+typedef struct {
+    /// How often the event occurred.
+    uint64_t count;
+
+    /// The total duration of the event in nanoseconds. Always 0 for events
+    /// that aren't timed.
+    uint64_t totalNanoseconds;
+
+    /// Bucket n counts the occurrences that took at least 2^n and less than
+    /// 2^(n+1) nanoseconds. The first bucket also counts shorter ones, and the
+    /// last bucket longer ones.
+    uint64_t histogram[ZTSQLiteInstrumentationHistogramBucketCount];
+} ZTSQLiteInstrumentationStatistics;
+
+/// A function called for every instrumentation event.
+///
+/// The function is called on the thread the event occurred on, possibly on
+/// several threads at once, and must return quickly.
+///
+/// modelClass  - The model class of the adapter reporting the event.
+/// event       - The event.
+/// nanoseconds - How long a timed event took, or 0.
+/// context     - The context passed to +setInstrumentationCallback:context:.
+typedef void (*ZTSQLiteInstrumentationCallback)(Class modelClass, ZTSQLiteInstrumentationEvent event, uint64_t nanoseconds, void *context);
+
+#endif
+
 /// Converts a MTLModel object to SQLite parameter dictionary (like in FMDB) with optional statement
 /// and from a SQLite result dictionary (like in FMDB).
+///
+/// Statements are generated once per table and set of columns and cached by the
+/// adapter. Columns always appear in the same order, and equal statements are
+/// returned as the same string instance, so a statement can be used as the key
+/// to reuse a prepared `sqlite3_stmt`.
 @interface ZTSQLiteAdapter : NSObject
 
 /// Attempts to parse a SQLite result dictionary into a model object.
@@ -92,6 +269,81 @@ extern const NSInteger ZTSQLiteAdapterErrorNoClassFound;
 /// occurred.
 + (id)modelOfClass:(Class)modelClass fromResultDictionary:(NSDictionary *)resultDictionary error:(NSError **)error;
 
+/// Attempts to parse the current row of a SQLite statement into a model object.
+///
+/// modelClass - The MTLModel subclass to attempt to parse from the row.
+///              This class must conform to <ZTSQLiteSerializing>. This
+///              argument must not be nil.
+/// statement  - A statement that has just returned SQLITE_ROW from sqlite3_step().
+///              With FMDB, this is `resultSet.statement.statement`. This argument
+///              must not be NULL.
+/// error      - If not NULL, this may be set to an error that occurs during
+///              parsing or initializing an instance of `modelClass`.
+///
+/// Returns an instance of `modelClass` upon success, or nil if a parsing error
+/// occurred.
++ (id)modelOfClass:(Class)modelClass fromStatement:(struct sqlite3_stmt *)statement error:(NSError **)error;
+
+/// Attempts to parse an array of SQLite result dictionaries into model objects.
+///
+/// modelClass         - The MTLModel subclass to attempt to parse from the dictionaries.
+///                      This class must conform to <ZTSQLiteSerializing>. This
+///                      argument must not be nil.
+/// resultDictionaries - An array of SQLite result dictionaries. This argument must
+///                      not be nil.
+/// error              - If not NULL, this may be set to the error of the first row
+///                      that failed to parse.
+///
+/// Returns an array of `modelClass` instances upon success, or nil if any row
+/// failed to parse.
++ (NSArray *)modelsOfClass:(Class)modelClass fromResultDictionaries:(NSArray *)resultDictionaries error:(NSError **)error;
+
+/// Attempts to parse an array of SQLite result dictionaries into model objects on
+/// multiple threads.
+///
+/// modelClass         - The MTLModel subclass to attempt to parse from the dictionaries.
+///                      This class must conform to <ZTSQLiteSerializing>. This
+///                      argument must not be nil.
+/// resultDictionaries - An array of SQLite result dictionaries. This argument must
+///                      not be nil.
+/// error              - If not NULL, this may be set to the error of the first row
+///                      that failed to parse.
+///
+/// Returns an array of `modelClass` instances in the order of `resultDictionaries`
+/// upon success, or nil if any row failed to parse.
++ (NSArray *)modelsOfClass:(Class)modelClass concurrentlyFromResultDictionaries:(NSArray *)resultDictionaries error:(NSError **)error;
+
+/// Steps a SQLite statement to completion and parses every row into a model object.
+///
+/// modelClass - The MTLModel subclass to attempt to parse from the rows.
+///              This class must conform to <ZTSQLiteSerializing>. This
+///              argument must not be nil.
+/// statement  - A prepared statement with its parameters bound. This argument
+///              must not be NULL.
+/// error      - If not NULL, this may be set to the error of the first row that
+///              failed to parse, or to the error stepping the statement.
+///
+/// Returns an array of `modelClass` instances upon success, or nil if an error
+/// occurred.
++ (NSArray *)modelsOfClass:(Class)modelClass fromStatement:(struct sqlite3_stmt *)statement error:(NSError **)error;
+
+/// Steps a SQLite statement to completion and passes every row, parsed into a model
+/// object, to a block while later rows are still being stepped and parsed.
+///
+/// modelClass - The MTLModel subclass to attempt to parse from the rows.
+///              This class must conform to <ZTSQLiteSerializing>. This
+///              argument must not be nil.
+/// statement  - A prepared statement with its parameters bound. This argument
+///              must not be NULL.
+/// block      - The block to call with every model and its row index, in row order.
+///              Setting `stop` to YES stops stepping. This argument must not be nil.
+/// error      - If not NULL, this may be set to the error of the first row that
+///              failed to parse, or to the error stepping the statement.
+///
+/// Returns whether all rows were stepped and parsed, or the block stopped the
+/// enumeration.
++ (BOOL)enumerateModelsOfClass:(Class)modelClass fromStatement:(struct sqlite3_stmt *)statement usingBlock:(void (^)(id model, NSUInteger idx, BOOL *stop))block error:(NSError **)error;
+
 /// Converts a model into SQLite parameter dictionary representation.
 ///
 /// model - The model to use for INSERT statement serialization. This argument must not be nil.
@@ -122,6 +374,166 @@ extern const NSInteger ZTSQLiteAdapterErrorNoClassFound;
 /// Returns a SQLite parameter dictionary representation, or nil if a serialization error occurred.
 + (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model deletingFromTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
 
+/// Converts a model into SQLite parameter dictionary representation.
+///
+/// model - The model whose row to select by primary key. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite SELECT statement.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns a SQLite parameter dictionary representation, or nil if a serialization error occurred.
++ (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model selectingFromTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Converts a model into SQLite parameter dictionary representation.
+///
+/// model - The model to use for upsert statement serialization. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite INSERT ... ON CONFLICT DO UPDATE statement.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns a SQLite parameter dictionary representation, or nil if a serialization error occurred.
++ (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model upsertingIntoTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Converts a model into a positional SQLite parameter array.
+///
+/// model - The model to use for INSERT statement serialization. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite INSERT statement using `?` placeholders.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of values in placeholder order, or nil if a serialization error occurred.
++ (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model insertingIntoTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Converts a model into a positional SQLite parameter array.
+///
+/// model - The model to use for UPDATE statement serialization. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite UPDATE statement using `?` placeholders.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of values in placeholder order, or nil if a serialization error occurred.
++ (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model updatingInTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Converts a model into a positional SQLite parameter array.
+///
+/// model - The model to use for DELETE statement serialization. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite DELETE statement using `?` placeholders.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of values in placeholder order, or nil if a serialization error occurred.
++ (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model deletingFromTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Converts a model into a positional SQLite parameter array.
+///
+/// model - The model whose row to select by primary key. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite SELECT statement using `?` placeholders.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of values in placeholder order, or nil if a serialization error occurred.
++ (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model selectingFromTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Converts a model into a positional SQLite parameter array.
+///
+/// model - The model to use for upsert statement serialization. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite INSERT ... ON CONFLICT DO UPDATE statement
+///             using `?` placeholders.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of values in placeholder order, or nil if a serialization error occurred.
++ (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model upsertingIntoTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Converts models into chunked multi-row INSERT statements with positional parameters.
+///
+/// models     - The models to insert. All models must be instances of the class of the
+///              first model or of its subclasses. This argument must not be nil.
+/// tableName  - The name of a table the statements will be executed on. This argument must not be nil.
+/// statements - If not NULL, this may be set to an array of multi-row INSERT statements using `?`
+///              placeholders, one for each returned parameter array.
+/// error      - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of parameter arrays, or nil if a serialization error occurred.
++ (NSArray *)parameterArraysFromModels:(NSArray *)models insertingIntoTable:(NSString *)tableName statements:(NSArray **)statements error:(NSError **)error;
+
+/// Converts models into chunked multi-row upsert statements with positional parameters.
+///
+/// models     - The models to upsert. All models must be instances of the class of the
+///              first model or of its subclasses. This argument must not be nil.
+/// tableName  - The name of a table the statements will be executed on. This argument must not be nil.
+/// statements - If not NULL, this may be set to an array of multi-row INSERT ... ON CONFLICT DO UPDATE
+///              statements using `?` placeholders, one for each returned parameter array.
+/// error      - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of parameter arrays, or nil if a model class has no primary
+/// keys or a serialization error occurred.
++ (NSArray *)parameterArraysFromModels:(NSArray *)models upsertingIntoTable:(NSString *)tableName statements:(NSArray **)statements error:(NSError **)error;
+
+/// Converts models into chunked set-based DELETE statements with positional parameters.
+///
+/// models     - The models to delete. All models must be instances of the class of the
+///              first model or of its subclasses. This argument must not be nil.
+/// tableName  - The name of a table the statements will be executed on. This argument must not be nil.
+/// statements - If not NULL, this may be set to an array of DELETE statements using `?`
+///              placeholders, one for each returned parameter array.
+/// error      - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of parameter arrays, or nil if a serialization error occurred.
++ (NSArray *)parameterArraysFromModels:(NSArray *)models deletingFromTable:(NSString *)tableName statements:(NSArray **)statements error:(NSError **)error;
+
+/// Returns a SELECT statement for models of the given class.
+///
+/// modelClass  - The MTLModel subclass to select. This class must conform to
+///               <ZTSQLiteSerializing>. This argument must not be nil.
+/// tableName   - The name of a table the statement will be executed on. This argument must not be nil.
+/// whereClause - The condition following WHERE, which may contain parameters, or nil
+///               to select all rows.
+///
+/// Returns a SELECT statement returning all mapped columns, which is cached if
+/// `whereClause` is nil.
++ (NSString *)statementForModelsOfClass:(Class)modelClass selectingFromTable:(NSString *)tableName where:(NSString *)whereClause;
+
+/// Binds the properties of a model to the named parameters of a prepared SQLite statement.
+///
+/// statement - A prepared statement using `:column` parameters, like the statements
+///             returned along with parameter dictionaries. This argument must not be NULL.
+/// model     - The model to bind. This argument must not be nil.
+/// error     - If not NULL, this may be set to an error that occurs during serializing
+///             or binding.
+///
+/// Returns whether all parameters naming a mapped column were bound.
++ (BOOL)bindParametersOfStatement:(struct sqlite3_stmt *)statement fromModel:(id<ZTSQLiteSerializing>)model error:(NSError **)error;
+
+/// Records that the current state of a model was written to its row.
+///
+/// If `model` was decoded by ZTSQLiteAdapter, the remembered column values used
+/// to track changes and to unique models are replaced by the current serialized
+/// values of the columns an UPDATE would write. Call this after successfully
+/// executing an UPDATE or upsert serialized for `model`. Serializing alone doesn't
+/// change what is remembered, so statements that are never executed or that fail
+/// don't cause changes to be skipped later. Other models are left untouched.
+///
+/// model - The model that was written. This argument must not be nil.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns whether the remembered values were replaced or didn't need to be.
++ (BOOL)didPersistModel:(id<ZTSQLiteSerializing>)model error:(NSError **)error;
+
+/// Binds a parameter array to the positional parameters of a prepared SQLite statement.
+///
+/// Values are bound the way FMDB binds them, so this can execute the statements
+/// returned along with parameter arrays without FMDB.
+///
+/// parameters - A parameter array, like one returned by the positional serializing
+///              methods. The first value is bound to the first parameter. This
+///              argument must not be nil.
+/// statement  - A prepared statement that has been reset. This argument must not be NULL.
+/// error      - If not NULL, this may be set to an error that occurs during binding.
+///
+/// Returns whether all parameters were bound.
++ (BOOL)bindParameters:(NSArray *)parameters toStatement:(struct sqlite3_stmt *)statement error:(NSError **)error;
+
 /// Attempts to parse a model to get column definition clause used in CREATE / ALTER statements
 ///
 /// modelClass     - The MTLModel subclass to attempt to parse from the JSON.
@@ -131,6 +543,21 @@ extern const NSInteger ZTSQLiteAdapterErrorNoClassFound;
 /// Returns a SQLite column definition clause, or nil if an error occurred.
 + (NSString *)columnDefinitionsOfClass:(Class)modelClass;
 
+/// Returns a shared adapter for the given model class.
+///
+/// Adapters are created on first use and cached for the lifetime of the process,
+/// keyed by both `modelClass` and the receiving adapter class, so subclasses of
+/// ZTSQLiteAdapter get their own instances. This method is thread-safe. Adapters
+/// are published to lookups in batches, so looking up most adapters takes no
+/// lock, while looking up one created since the last batch does.
+///
+/// modelClass - The MTLModel subclass to attempt to parse from the SQLite result dictionary
+///              and back. This class must conform to <ZTSQLiteSerializing>. This
+///              argument must not be nil.
+///
+/// Returns a shared adapter, or nil if no adapter could be created.
++ (instancetype)adapterForModelClass:(Class)modelClass;
+
 /// Initializes the receiver with a given model class.
 ///
 /// modelClass - The MTLModel subclass to attempt to parse from the SQLite result dictionary
@@ -140,10 +567,19 @@ extern const NSInteger ZTSQLiteAdapterErrorNoClassFound;
 /// Returns an initialized adapter.
 - (instancetype)initWithModelClass:(Class)modelClass;
 
+/// When the receiver calls -validate: on the models it decodes, as specified
+/// by +[<ZTSQLiteSerializing> SQLiteValidationPolicy] of the model class.
+@property (nonatomic, assign, readonly) ZTSQLiteValidationPolicy validationPolicy;
+
+/// How many decoded models share one validation when `validationPolicy` is
+/// ZTSQLiteValidationPolicySampled, as specified by
+/// +[<ZTSQLiteSerializing> SQLiteValidationSamplingInterval] of the model class.
+@property (nonatomic, assign, readonly) NSUInteger validationSamplingInterval;
+
 /// Deserializes a model from a SQLite result dictionary.
 ///
-/// The adapter will call -validate: on the model and consider it an error if the
-/// validation fails.
+/// Depending on `validationPolicy`, the adapter will call -validate: on the model
+/// and consider it an error if the validation fails.
 ///
 /// resultDictionary    - A result dictionary. This argument must not be nil.
 /// error               - If not NULL, this may be set to an error that occurs during
@@ -153,6 +589,219 @@ extern const NSInteger ZTSQLiteAdapterErrorNoClassFound;
 /// model did not validate successfully.
 - (id)modelFromResultDictionary:(NSDictionary *)resultDictionary error:(NSError **)error;
 
+/// Deserializes only some properties of a model from a SQLite result dictionary.
+///
+/// Use this method with a result of a SELECT statement that only returns some
+/// of the mapped columns, like one using -columnListForPropertyKeys:. Properties
+/// not in `propertyKeys` are not decoded and keep the values set by the model's
+/// initializer.
+///
+/// UPDATE statements and upserts serialized for the returned model only write
+/// the decoded columns. If a primary key column was not decoded, serializing
+/// an UPDATE, DELETE or upsert for it fails with
+/// ZTSQLiteAdapterErrorPrimaryKeyNotDecoded.
+///
+/// resultDictionary - A result dictionary. This argument must not be nil.
+/// propertyKeys     - The property keys to decode, or nil to decode all mapped properties.
+/// error            - If not NULL, this may be set to an error that occurs during
+///                    deserializing or validation.
+///
+/// Returns a model object, or nil if a deserialization error occurred or the
+/// model did not validate successfully.
+- (id)modelFromResultDictionary:(NSDictionary *)resultDictionary propertyKeys:(NSSet *)propertyKeys error:(NSError **)error;
+
+/// Deserializes a model from the current row of a SQLite statement.
+///
+/// Column values are read directly through the sqlite3_column_* accessors
+/// without building a result dictionary, unless the model class implements
+/// +classForParsingResultDictionary:, which needs one. Integer and real values
+/// of scalar properties using the default transformers are set without being
+/// boxed, unless the model class tracks changes or uses an identity map.
+///
+/// Depending on `validationPolicy`, the adapter will call -validate: on the model
+/// and consider it an error if the validation fails.
+///
+/// statement - A statement that has just returned SQLITE_ROW from sqlite3_step().
+///             With FMDB, this is `resultSet.statement.statement`. This argument
+///             must not be NULL.
+/// error     - If not NULL, this may be set to an error that occurs during
+///             deserializing or validation.
+///
+/// Returns a model object, or nil if a deserialization error occurred or the
+/// model did not validate successfully.
+- (id)modelFromStatement:(struct sqlite3_stmt *)statement error:(NSError **)error;
+
+/// Deserializes only some properties of a model from the current row of a SQLite
+/// statement.
+///
+/// The result columns are resolved once and reused while the same statement is
+/// passed with the same property keys, identified by its pointer and SQL. The
+/// adapter only remembers the last statement, so decoding rows of several
+/// statements in turn resolves them again. To decode all rows of a statement,
+/// -modelsFromStatement:propertyKeys:errorsByIndex:error: and
+/// -enumerateModelsFromStatement:propertyKeys:usingBlock:error: are faster.
+///
+/// statement    - A statement that has just returned SQLITE_ROW from sqlite3_step().
+///                This argument must not be NULL.
+/// propertyKeys - The property keys to decode, or nil to decode all mapped properties.
+/// error        - If not NULL, this may be set to an error that occurs during
+///                deserializing or validation.
+///
+/// Returns a model object, or nil if a deserialization error occurred or the
+/// model did not validate successfully.
+- (id)modelFromStatement:(struct sqlite3_stmt *)statement propertyKeys:(NSSet *)propertyKeys error:(NSError **)error;
+
+/// Deserializes models from an array of SQLite result dictionaries.
+///
+/// Per-class work is done once for the whole batch, and autoreleased objects are
+/// drained periodically.
+///
+/// resultDictionaries - An array of result dictionaries. This argument must not be nil.
+/// errorsByIndex      - If not NULL, rows that fail to deserialize are skipped
+///                      instead of failing the batch. On return, this is set to a
+///                      dictionary mapping the index of every skipped row to its
+///                      error, or nil if no row failed.
+/// error              - If not NULL, this may be set to the error of the first row
+///                      that failed when `errorsByIndex` is NULL.
+///
+/// Returns an array of model objects in the order of `resultDictionaries`, or
+/// nil if a row failed and `errorsByIndex` is NULL.
+- (NSArray *)modelsFromResultDictionaries:(NSArray *)resultDictionaries errorsByIndex:(NSDictionary **)errorsByIndex error:(NSError **)error;
+
+/// Deserializes only some properties of models from an array of SQLite result
+/// dictionaries.
+///
+/// resultDictionaries - An array of result dictionaries. This argument must not be nil.
+/// propertyKeys       - The property keys to decode, or nil to decode all mapped properties.
+/// errorsByIndex      - If not NULL, rows that fail to deserialize are skipped, like in
+///                      -modelsFromResultDictionaries:errorsByIndex:error:.
+/// error              - If not NULL, this may be set to the error of the first row
+///                      that failed when `errorsByIndex` is NULL.
+///
+/// Returns an array of model objects in the order of `resultDictionaries`, or
+/// nil if a row failed and `errorsByIndex` is NULL.
+- (NSArray *)modelsFromResultDictionaries:(NSArray *)resultDictionaries propertyKeys:(NSSet *)propertyKeys errorsByIndex:(NSDictionary **)errorsByIndex error:(NSError **)error;
+
+/// Deserializes models from an array of SQLite result dictionaries on multiple threads.
+///
+/// The rows are split into chunks that are decoded with dispatch_apply(), which
+/// runs as many chunks at once as there are cores, and the models are returned
+/// in their original order. Errors are reported exactly like
+/// -modelsFromResultDictionaries:propertyKeys:errorsByIndex:error: would report
+/// them. Small arrays are decoded on the calling thread.
+///
+/// The value transformers and validation methods of the model classes must be
+/// safe to call from several threads at once.
+///
+/// resultDictionaries - An array of result dictionaries. This argument must not be nil.
+/// propertyKeys       - The property keys to decode, or nil to decode all mapped properties.
+/// errorsByIndex      - If not NULL, rows that fail to deserialize are skipped, like in
+///                      -modelsFromResultDictionaries:errorsByIndex:error:.
+/// error              - If not NULL, this may be set to the error of the first row
+///                      that failed when `errorsByIndex` is NULL.
+///
+/// Returns an array of model objects in the order of `resultDictionaries`, or
+/// nil if a row failed and `errorsByIndex` is NULL.
+- (NSArray *)modelsConcurrentlyFromResultDictionaries:(NSArray *)resultDictionaries propertyKeys:(NSSet *)propertyKeys errorsByIndex:(NSDictionary **)errorsByIndex error:(NSError **)error;
+
+/// Steps a SQLite statement until SQLITE_DONE and deserializes every row.
+///
+/// Result columns are resolved once for the whole statement. The statement is
+/// neither reset nor finalized.
+///
+/// statement     - A prepared statement with its parameters bound. With FMDB, this
+///                 is `resultSet.statement.statement`. This argument must not be NULL.
+/// errorsByIndex - If not NULL, rows that fail to deserialize are skipped
+///                 instead of failing the batch. On return, this is set to a
+///                 dictionary mapping the index of every skipped row to its
+///                 error, or nil if no row failed.
+/// error         - If not NULL, this may be set to the error stepping the
+///                 statement, or to the error of the first row that failed when
+///                 `errorsByIndex` is NULL.
+///
+/// Returns an array of model objects in row order, or nil if an error occurred.
+- (NSArray *)modelsFromStatement:(struct sqlite3_stmt *)statement errorsByIndex:(NSDictionary **)errorsByIndex error:(NSError **)error;
+
+/// Steps a SQLite statement until SQLITE_DONE and deserializes only some
+/// properties of every row.
+///
+/// statement     - A prepared statement with its parameters bound. This argument
+///                 must not be NULL.
+/// propertyKeys  - The property keys to decode, or nil to decode all mapped properties.
+/// errorsByIndex - If not NULL, rows that fail to deserialize are skipped, like in
+///                 -modelsFromStatement:errorsByIndex:error:.
+/// error         - If not NULL, this may be set to the error stepping the
+///                 statement, or to the error of the first row that failed when
+///                 `errorsByIndex` is NULL.
+///
+/// Returns an array of model objects in row order, or nil if an error occurred.
+- (NSArray *)modelsFromStatement:(struct sqlite3_stmt *)statement propertyKeys:(NSSet *)propertyKeys errorsByIndex:(NSDictionary **)errorsByIndex error:(NSError **)error;
+
+/// Steps a SQLite statement until SQLITE_DONE and streams the deserialized models
+/// to a block.
+///
+/// The calling thread steps the statement and copies the raw rows into chunks,
+/// which are deserialized on a concurrent queue while the next rows are stepped.
+/// Models are passed to `block` in row order on a private serial queue, so the
+/// block must not wait for the calling thread. At most 1024 rows are stepped
+/// ahead of the block, and stepping waits for the block to catch up, so memory
+/// use doesn't grow with the number of rows. Models are not retained once the
+/// block returns.
+///
+/// This method returns once the block has been called for the last time. The
+/// value transformers and validation methods of the model classes must be safe
+/// to call from several threads at once.
+///
+/// statement    - A prepared statement with its parameters bound. This argument
+///                must not be NULL.
+/// propertyKeys - The property keys to decode, or nil to decode all mapped properties.
+/// block        - The block to call with every model and its row index. Setting
+///                `stop` to YES stops stepping, and no more models are passed to
+///                the block. This argument must not be nil.
+/// error        - If not NULL, this may be set to the error of the first row that
+///                failed to deserialize, or to the error stepping the statement.
+///                Rows before the failed row are passed to the block first.
+///
+/// Returns whether all rows were stepped and deserialized, or the block stopped
+/// the enumeration.
+- (BOOL)enumerateModelsFromStatement:(struct sqlite3_stmt *)statement propertyKeys:(NSSet *)propertyKeys usingBlock:(void (^)(id model, NSUInteger idx, BOOL *stop))block error:(NSError **)error;
+
+/// Returns the column list of a SELECT statement returning the given properties.
+///
+/// propertyKeys - The property keys to select, or nil to select all mapped properties.
+///                Keys that are not mapped to a column are ignored.
+///
+/// Returns the column names of `propertyKeys` separated by commas, in the order
+/// the adapter decodes them.
+- (NSString *)columnListForPropertyKeys:(NSSet *)propertyKeys;
+
+/// Returns a SELECT statement returning all mapped columns.
+///
+/// The columns are selected in the order the adapter decodes them, which lets
+/// -modelFromStatement:error: and friends resolve them without searching.
+/// Statements without a WHERE clause are cached like INSERT, UPDATE and DELETE
+/// statements. Statements with one are built on every call, since WHERE clauses
+/// may embed values.
+///
+/// tableName   - The name of a table the statement will be executed on. This argument must not be nil.
+/// whereClause - The condition following WHERE, which may contain parameters, or nil
+///               to select all rows.
+///
+/// Returns a SELECT statement.
+- (NSString *)statementSelectingFromTable:(NSString *)tableName where:(NSString *)whereClause;
+
+/// Returns a SELECT statement returning the columns of the given properties.
+///
+/// Use it with the propertyKeys: variants of the decoding methods.
+///
+/// propertyKeys - The property keys to select, or nil to select all mapped properties.
+/// tableName    - The name of a table the statement will be executed on. This argument must not be nil.
+/// whereClause  - The condition following WHERE, which may contain parameters, or nil
+///                to select all rows.
+///
+/// Returns a SELECT statement, which is cached if `whereClause` is nil.
+- (NSString *)statementSelectingPropertyKeys:(NSSet *)propertyKeys fromTable:(NSString *)tableName where:(NSString *)whereClause;
+
 /// Serializes a model into SQLite parameter dictionary representation.
 ///
 /// model - The model to use for INSERT statement serialization. This argument must not be nil.
@@ -165,9 +814,15 @@ extern const NSInteger ZTSQLiteAdapterErrorNoClassFound;
 
 /// Serializes a model into SQLite parameter dictionary representation.
 ///
-/// model - The model to use for INSERT statement serialization. This argument must not be nil.
+/// If the model class tracks changes and `model` was decoded by the adapter,
+/// only the columns that changed since it was decoded or last passed to
+/// -didPersistModel:error: are updated. If no column changed, `statement` is set to
+/// nil and an empty dictionary is returned.
+///
+/// model - The model to use for UPDATE statement serialization. This argument must not be nil.
 /// tableName - The name of a table the statement will be executed on. This argument must not be nil.
-/// statement - If not NULL, this may be set to a SQLite UPDATE statement.
+/// statement - If not NULL, this may be set to a SQLite UPDATE statement, or to nil
+///             if there is nothing to update.
 /// error - If not NULL, this may be set to an error that occurs during serializing.
 ///
 /// Returns a SQLite parameter dictionary representation, or nil if a serialization error occurred.
@@ -183,6 +838,205 @@ extern const NSInteger ZTSQLiteAdapterErrorNoClassFound;
 /// Returns a SQLite parameter dictionary representation, or nil if a serialization error occurred.
 - (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model deletingFromTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
 
+/// Serializes a model into SQLite parameter dictionary representation for an
+/// upsert, which inserts a row or updates it if it already exists.
+///
+/// The statement is an `INSERT ... ON CONFLICT (...) DO UPDATE SET ...` with the
+/// primary key columns as the conflict target. The columns returned by
+/// -insertablePropertyKeys:forModel: and the primary key columns are inserted.
+/// On conflict, the inserted columns that are also returned by
+/// -updatablePropertyKeys:forModel: are overwritten with the new values. Upserts
+/// require SQLite 3.24 or later.
+///
+/// model - The model to use for upsert statement serialization. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite INSERT ... ON CONFLICT DO UPDATE statement.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns a SQLite parameter dictionary representation, or nil if the model class
+/// has no primary keys or a serialization error occurred.
+- (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model upsertingIntoTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Serializes a model into a positional SQLite parameter array.
+///
+/// Unlike a parameter dictionary, the values are ordered to match the `?`
+/// placeholders of the returned statement, so they can be bound by index
+/// without resolving parameter names. The statement is cached and its
+/// placeholder order never changes for the same set of columns.
+///
+/// model - The model to use for INSERT statement serialization. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite INSERT statement using `?` placeholders.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of values in placeholder order, or nil if a serialization error occurred.
+- (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model insertingIntoTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Serializes a model into a positional SQLite parameter array.
+///
+/// The values of the updated columns come first, followed by the values of the
+/// primary key columns used in the WHERE clause. Changes are tracked like in
+/// -parameterDictionaryFromModel:updatingInTable:statement:error:, and an empty
+/// array is returned if no column changed.
+///
+/// model - The model to use for UPDATE statement serialization. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite UPDATE statement using `?` placeholders,
+///             or to nil if there is nothing to update.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of values in placeholder order, or nil if the model class
+/// has no primary keys or a serialization error occurred.
+- (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model updatingInTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Serializes a model into a positional SQLite parameter array.
+///
+/// model - The model to use for DELETE statement serialization. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite DELETE statement using `?` placeholders.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of values in placeholder order, or nil if the model class
+/// has no primary keys or a serialization error occurred.
+- (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model deletingFromTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Serializes a model into a positional SQLite parameter array for an upsert.
+///
+/// The statement is generated like in
+/// -parameterDictionaryFromModel:upsertingIntoTable:statement:error:. The
+/// updated columns refer to the `excluded` row, so only the inserted values
+/// are bound.
+///
+/// model - The model to use for upsert statement serialization. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite INSERT ... ON CONFLICT DO UPDATE statement
+///             using `?` placeholders.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of values in placeholder order, or nil if the model class
+/// has no primary keys or a serialization error occurred.
+- (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model upsertingIntoTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Serializes the primary key of a model into SQLite parameter dictionary
+/// representation, to look up the row of the model.
+///
+/// The statement selects all mapped columns like
+/// -statementSelectingFromTable:where:, with the primary key columns as the
+/// condition.
+///
+/// model - The model whose row to select. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite SELECT statement.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns a SQLite parameter dictionary representation, or nil if the model class
+/// has no primary keys or a serialization error occurred.
+- (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model selectingFromTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Serializes the primary key of a model into a positional SQLite parameter
+/// array, to look up the row of the model.
+///
+/// model - The model whose row to select. This argument must not be nil.
+/// tableName - The name of a table the statement will be executed on. This argument must not be nil.
+/// statement - If not NULL, this may be set to a SQLite SELECT statement using `?` placeholders.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of primary key values in placeholder order, or nil if the
+/// model class has no primary keys or a serialization error occurred.
+- (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model selectingFromTable:(NSString *)tableName statement:(NSString **)statement error:(NSError **)error;
+
+/// Serializes models into chunked multi-row INSERT statements with positional parameters.
+///
+/// Consecutive models that insert the same columns share a statement of the form
+/// `INSERT INTO table (a, b) VALUES (?, ?), (?, ?), ...;`. A new statement is started
+/// whenever the inserted columns change or the statement would exceed SQLite's
+/// default limits of 999 variables or 500 rows. A model that inserts no columns gets a
+/// statement of its own of the form `INSERT INTO table DEFAULT VALUES;` with an empty
+/// parameter array. Statements are cached like single-row statements.
+///
+/// models     - The models to insert. This argument must not be nil.
+/// tableName  - The name of a table the statements will be executed on. This argument must not be nil.
+/// statements - If not NULL, this may be set to an array of multi-row INSERT statements, one for
+///              each returned parameter array.
+/// error      - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of parameter arrays. Each is a flat array of values in the
+/// order of the `?` placeholders of the corresponding statement. Returns nil if a
+/// serialization error occurred.
+- (NSArray *)parameterArraysFromModels:(NSArray *)models insertingIntoTable:(NSString *)tableName statements:(NSArray **)statements error:(NSError **)error;
+
+/// Serializes models into chunked multi-row upsert statements with positional parameters.
+///
+/// Consecutive models that insert the same columns and overwrite the same columns on
+/// conflict share a statement of the form
+/// `INSERT INTO table (a, b) VALUES (?, ?), (?, ?), ... ON CONFLICT (a) DO UPDATE SET b = excluded.b;`.
+/// Chunks are limited like those of -parameterArraysFromModels:insertingIntoTable:statements:error:.
+/// Upserts need SQLite 3.24 or later.
+///
+/// models     - The models to upsert. This argument must not be nil.
+/// tableName  - The name of a table the statements will be executed on. This argument must not be nil.
+/// statements - If not NULL, this may be set to an array of multi-row upsert statements, one for
+///              each returned parameter array.
+/// error      - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of parameter arrays. Each is a flat array of values in the
+/// order of the `?` placeholders of the corresponding statement. Returns nil if a
+/// model class has no primary keys or a serialization error occurred.
+- (NSArray *)parameterArraysFromModels:(NSArray *)models upsertingIntoTable:(NSString *)tableName statements:(NSArray **)statements error:(NSError **)error;
+
+/// Serializes models into chunked set-based DELETE statements with positional parameters.
+///
+/// Instead of one statement per model, consecutive models with the same primary
+/// key columns share a statement. A single-column primary key produces
+/// `DELETE FROM table WHERE pk IN (?, ?, ...);`, and a composite primary key produces
+/// `DELETE FROM table WHERE (a, b) IN (VALUES (?, ?), (?, ?), ...);` if the linked
+/// SQLite is 3.15 or later, which added row values, and
+/// `DELETE FROM table WHERE (a = ? AND b = ?) OR (a = ? AND b = ?) ...;` otherwise.
+/// Both bind the same parameters. A new statement is started whenever the
+/// statement would exceed SQLite's default limits of 999 variables, or of 500
+/// rows for composite primary keys.
+/// Statements are cached like single-row statements.
+///
+/// models     - The models to delete. This argument must not be nil.
+/// tableName  - The name of a table the statements will be executed on. This argument must not be nil.
+/// statements - If not NULL, this may be set to an array of DELETE statements, one for each
+///              returned parameter array.
+/// error      - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns an array of parameter arrays. Each is a flat array of primary key values
+/// in the order of the `?` placeholders of the corresponding statement. Returns nil
+/// if a model class has no primary keys or a serialization error occurred.
+- (NSArray *)parameterArraysFromModels:(NSArray *)models deletingFromTable:(NSString *)tableName statements:(NSArray **)statements error:(NSError **)error;
+
+/// Binds the properties of a model to the named parameters of a prepared SQLite statement.
+///
+/// Parameters are matched to columns by name, so a statement prepared once from one
+/// of the statements returned along with parameter dictionaries can be reset and
+/// bound again for every model, without building parameter dictionaries. Scalar
+/// properties using the default transformers are bound with sqlite3_bind_int64()
+/// or sqlite3_bind_double() without being boxed. Other values are bound the way
+/// FMDB binds them. Parameters that don't name a mapped column are left untouched.
+///
+/// statement - A prepared statement using `:column` parameters. With FMDB, this is
+///             `statement.statement` of a cached FMStatement. This argument must
+///             not be NULL.
+/// model     - The model to bind. This argument must not be nil.
+/// error     - If not NULL, this may be set to an error that occurs during serializing
+///             or binding.
+///
+/// Returns whether all parameters naming a mapped column were bound.
+- (BOOL)bindParametersOfStatement:(struct sqlite3_stmt *)statement fromModel:(id<ZTSQLiteSerializing>)model error:(NSError **)error;
+
+/// Records that the current state of a model was written to its row.
+///
+/// See +didPersistModel:error:.
+///
+/// model - The model that was written. This argument must not be nil.
+/// error - If not NULL, this may be set to an error that occurs during serializing.
+///
+/// Returns whether the remembered values were replaced or didn't need to be.
+- (BOOL)didPersistModel:(id<ZTSQLiteSerializing>)model error:(NSError **)error;
+
 /// Filters the property keys used to insert a given model.
 ///
 /// propertyKeys - The property keys for which `model` provides a mapping.
@@ -245,6 +1099,46 @@ extern const NSInteger ZTSQLiteAdapterErrorNoClassFound;
 
 @end
 
+#if ZTSQLITE_INSTRUMENTATION
+
+@interface ZTSQLiteAdapter (Instrumentation)
+
+/// Whether adapters aggregate statistics of instrumentation events. Defaults to NO.
++ (BOOL)recordsInstrumentation;
+
+/// Enables or disables aggregating statistics of instrumentation events in all
+/// adapters. This method is thread-safe.
++ (void)setRecordsInstrumentation:(BOOL)recordsInstrumentation;
+
+/// Sets a function to be called for every instrumentation event of all adapters,
+/// in addition to aggregating statistics. This method is thread-safe.
+///
+/// Events that are being reported while the callback is replaced may still be
+/// reported to the previous callback.
+///
+/// callback - The function to call, or NULL to stop calling the current one.
+/// context  - An arbitrary pointer passed to `callback`.
++ (void)setInstrumentationCallback:(ZTSQLiteInstrumentationCallback)callback context:(void *)context;
+
+/// Returns the statistics of an event aggregated by the receiver while
+/// +recordsInstrumentation was YES.
+///
+/// Adapters returned by +adapterForModelClass: are shared, so their statistics
+/// cover all uses of their model class. Events of subclasses returned by
+/// +classForParsingResultDictionary: are aggregated by the adapters of the
+/// subclasses. Since the statistics are updated without a lock, the fields may
+/// be slightly out of sync while models are decoded or encoded.
+///
+/// event - The event whose statistics to return.
+- (ZTSQLiteInstrumentationStatistics)instrumentationStatisticsForEvent:(ZTSQLiteInstrumentationEvent)event;
+
+/// Resets the aggregated statistics of all events of the receiver to zero.
+- (void)resetInstrumentationStatistics;
+
+@end
+
+#endif
+
 @interface ZTSQLiteAdapter (Deprecated)
 
 - (instancetype)init __attribute__((unavailable("Use one of convenience methods instead")));
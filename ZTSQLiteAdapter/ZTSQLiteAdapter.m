@@ -9,9 +9,16 @@
 #import "ZTSQLiteAdapter.h"
 #import "EXTRuntimeExtensions.h"
 #import "EXTScope.h"
+#import <mach/mach_time.h>
+#import <objc/message.h>
+#import <sqlite3.h>
+#import <stdatomic.h>
 
 NSString * const ZTSQLiteAdapterErrorDomain = @"ZTSQLiteAdapterErrorDomain";
 const NSInteger ZTSQLiteAdapterErrorNoClassFound = 2;
+const NSInteger ZTSQLiteAdapterErrorStatementFailed = 3;
+const NSInteger ZTSQLiteAdapterErrorInvalidRow = 4;
+const NSInteger ZTSQLiteAdapterErrorPrimaryKeyNotDecoded = 5;
 
 // An exception was thrown and caught.
 const NSInteger ZTSQLiteAdapterErrorExceptionThrown = 1;
@@ -19,6 +26,65 @@ const NSInteger ZTSQLiteAdapterErrorExceptionThrown = 1;
 // Associated with the NSException that was caught.
 static NSString * const ZTSQLiteAdapterThrownExceptionErrorKey = @"ZTSQLiteAdapterThrownException";
 
+// The number of rows decoded in batch methods between draining autorelease pools.
+static const NSUInteger ZTSQLiteAdapterBatchSize = 256;
+
+// The number of rows stepped into each chunk when streaming models.
+static const NSUInteger ZTSQLiteAdapterStreamChunkSize = 64;
+
+// The number of chunks that may be stepped ahead of the block when streaming
+// models.
+static const NSUInteger ZTSQLiteAdapterStreamChunkCount = 16;
+
+// The default SQLITE_MAX_VARIABLE_NUMBER of SQLite builds shipped by the OS.
+static const NSUInteger ZTSQLiteAdapterMaximumVariableNumber = 999;
+
+// The default SQLITE_MAX_COMPOUND_SELECT, which older SQLite versions also
+// apply to the rows of a multi-row VALUES clause. It also keeps the OR chains
+// deleting by composite primary key below the default SQLITE_MAX_EXPR_DEPTH
+// of 1000.
+static const NSUInteger ZTSQLiteAdapterMaximumRowsPerStatement = 500;
+
+// The key of the column snapshot associated with decoded models whose class
+// tracks changes or uses an identity map. Like all associations with decoded
+// models, it is retained atomically, since models may be shared across threads
+// while the snapshot is replaced.
+static char ZTSQLiteChangeSnapshotKey;
+
+// The key of the projection associated with models decoded from only some of
+// the mapped columns.
+static char ZTSQLiteProjectionKey;
+
+// Stands in for columns missing from the result a model was decoded from.
+// Never equal to a serialized value, so such columns are always updated.
+static id ZTSQLiteMissingColumnValue(void) {
+    static id missingColumnValue = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        missingColumnValue = [[NSObject alloc] init];
+    });
+    return missingColumnValue;
+}
+
+NSError *ZTSQLiteAdapterInvalidRowError(void) {
+    NSDictionary *userInfo = @{ NSLocalizedDescriptionKey: NSLocalizedString(@"Could not parse SQLite row", @""),
+                                NSLocalizedFailureReasonErrorKey: NSLocalizedString(@"The row could not be converted into a model object.", @"")
+                                };
+
+    return [NSError errorWithDomain:ZTSQLiteAdapterErrorDomain code:ZTSQLiteAdapterErrorInvalidRow userInfo:userInfo];
+}
+
+NSError *ZTSQLiteAdapterStatementFailedError(sqlite3 *database, int resultCode) {
+    NSCParameterAssert(database != NULL);
+
+    const char *message = sqlite3_errmsg(database);
+    NSDictionary *userInfo = @{ NSLocalizedDescriptionKey: NSLocalizedString(@"Could not execute SQLite statement", @""),
+                                NSLocalizedFailureReasonErrorKey: message ? @(message) : [NSString stringWithFormat:@"SQLite error %d", resultCode]
+                                };
+
+    return [NSError errorWithDomain:ZTSQLiteAdapterErrorDomain code:ZTSQLiteAdapterErrorStatementFailed userInfo:userInfo];
+}
+
 static SEL MTLSelectorWithKeyPattern(NSString *key, const char *suffix) {
     NSUInteger keyLength = [key maximumLengthOfBytesUsingEncoding:NSUTF8StringEncoding];
     NSUInteger suffixLength = strlen(suffix);
@@ -34,337 +100,3355 @@ static SEL MTLSelectorWithKeyPattern(NSString *key, const char *suffix) {
     return sel_registerName(selector);
 }
 
-@interface ZTSQLiteAdapter ()
+// Calls the class method of `class` named `<key><suffix>`, which must take no
+// arguments and return an object. Methods added by +resolveClassMethod: are
+// found like by -respondsToSelector:.
+//
+// Returns the return value of the method, or nil if `class` doesn't respond to it.
+static id ZTSQLiteCallClassMethodWithKeyPattern(Class class, NSString *key, const char *suffix) {
+    SEL selector = MTLSelectorWithKeyPattern(key, suffix);
+    if (selector == NULL || ![class respondsToSelector:selector]) {
+        return nil;
+    }
 
-// The MTLModel subclass being parsed, or the class of `model` if parsing has
-// completed.
-@property (nonatomic, strong, readonly) Class modelClass;
+    id (*function)(id, SEL) = (id (*)(id, SEL))[class methodForSelector:selector];
+    return function(class, selector);
+}
 
-// A cached copy of the return value of +SQLiteColumnNamesByPropertyKey.
-@property (nonatomic, copy, readonly) NSDictionary *SQLiteColumnNamesByPropertyKey;
+// Returns the result of the `+<key>SQLiteColumnTransformer` method of
+// `modelClass`, NSNull if the method returns nil, or nil if `modelClass`
+// doesn't respond to it.
+//
+// The selector is only built and looked up once for each model class and key.
+// Results are cached by model class rather than by the class implementing the
+// method, so methods added by +resolveClassMethod: are found like by
+// -respondsToSelector:.
+static id ZTSQLiteKeyedColumnTransformerOfModelClass(Class modelClass, NSString *key) {
+    static NSMapTable *resultsByModelClass = nil;
+    static id missingMethod = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        resultsByModelClass = [NSMapTable strongToStrongObjectsMapTable];
+        missingMethod = [[NSObject alloc] init];
+    });
+
+    NSMutableDictionary *resultsByKey = nil;
+    id result = nil;
+
+    @synchronized(resultsByModelClass) {
+        resultsByKey = [resultsByModelClass objectForKey:modelClass];
+        if (resultsByKey == nil) {
+            resultsByKey = [NSMutableDictionary dictionary];
+            [resultsByModelClass setObject:resultsByKey forKey:modelClass];
+        }
 
-// A cached copy of the return value of -valueTransformersForModelClass:
-@property (nonatomic, copy, readonly) NSDictionary *valueTransformersByPropertyKey;
+        result = resultsByKey[key];
+    }
 
-// Used to cache the SQLite adapters returned by -SQLiteAdapterForModelClass:error:.
-@property (nonatomic, strong, readonly) NSMapTable *SQLiteAdaptersByModelClass;
+    // Like adapter transformer methods, the method is called without holding
+    // the lock, and the result published first wins.
+    if (result == nil) {
+        id transformer = missingMethod;
 
-// If +classForParsingResultDictionary: returns a model class different from the
-// one this adapter was initialized with, use this method to obtain a cached
-// instance of a suitable adapter instead.
+        SEL selector = MTLSelectorWithKeyPattern(key, "SQLiteColumnTransformer");
+        if (selector != NULL && [modelClass respondsToSelector:selector]) {
+            id (*function)(id, SEL) = (id (*)(id, SEL))[modelClass methodForSelector:selector];
+            transformer = function(modelClass, selector) ?: NSNull.null;
+        }
+
+        @synchronized(resultsByModelClass) {
+            result = resultsByKey[key];
+            if (result == nil) {
+                result = transformer;
+                resultsByKey[key] = result;
+            }
+        }
+    }
+
+    return result != missingMethod ? result : nil;
+}
+
+// Describes how a single mapped property is read from and written to its column.
 //
-// modelClass - The class from which to parse the result dictionary. This class must conform
-//              to <ZTSQLiteSerializing>. This argument must not be nil.
-// error -      If not NULL, this may be set to an error that occurs during
-//              initializing the adapter.
+// Object references are unretained; they are owned by the adapter's
+// immutable dictionaries and property key array.
+typedef struct {
+    // The property key of the model.
+    __unsafe_unretained NSString *propertyKey;
+
+    // The column name the property is mapped to.
+    __unsafe_unretained NSString *columnName;
+
+    // A NUL-terminated UTF-8 copy of `columnName` owned by the column plan.
+    char *columnNameUTF8;
+
+    // The value transformer for the property, or nil.
+    __unsafe_unretained NSValueTransformer *transformer;
+
+    // The position of this column in the adapter's column plan.
+    NSUInteger index;
+
+    // Whether `transformer` implements -transformedValue:success:error:.
+    BOOL transformerHandlesErrors;
+
+    // Whether `transformer` can be used when serializing.
+    BOOL transformerAllowsReverseTransformation;
+
+    // Whether `transformer` implements -reverseTransformedValue:success:error:.
+    BOOL reverseTransformerHandlesErrors;
+
+    // The getter implementation of an object-typed property, or NULL if the
+    // property value has to be read through KVC.
+    IMP getterImplementation;
+
+    // The selector for the getter of the property.
+    SEL getter;
+
+    // Whether the transformer runs when the property is first read instead of
+    // when the model is decoded.
+    BOOL lazy;
+
+    // The selector and implementation of the object-typed setter KVC would use
+    // to set the property, or NULL if the property has to be set through KVC.
+    SEL setter;
+    IMP setterImplementation;
+
+    // The type encoding of a scalar property that is read and written as a raw
+    // C value instead of a boxed NSNumber, like 'q' or 'd', or 0.
+    char scalarType;
+
+    // Whether the scalar property is a BOOL, whose values are normalized to 0
+    // or 1 like MTLBooleanValueTransformerName does.
+    BOOL scalarIsBoolean;
+
+    // The getter of the scalar property.
+    SEL scalarGetter;
+    IMP scalarGetterImplementation;
+
+    // The scalar-typed setter KVC would use to set the property, or NULL if
+    // decoded values have to be set through KVC.
+    SEL scalarSetter;
+    IMP scalarSetterImplementation;
+} ZTSQLiteColumn;
+
+// A raw INTEGER or REAL column value.
+typedef struct {
+    // SQLITE_INTEGER or SQLITE_FLOAT, or 0 if there is no raw value.
+    int type;
+
+    union {
+        sqlite3_int64 integerValue;
+        double realValue;
+    };
+} ZTSQLiteScalarValue;
+
+// Expands `X(encoding, type)` for every scalar type that can be read and
+// written without boxing.
+#define ZTSQLITE_SCALAR_TYPES(X) \
+    X('c', char) \
+    X('B', bool) \
+    X('s', short) \
+    X('i', int) \
+    X('l', long) \
+    X('q', long long) \
+    X('C', unsigned char) \
+    X('S', unsigned short) \
+    X('I', unsigned int) \
+    X('L', unsigned long) \
+    X('Q', unsigned long long) \
+    X('f', float) \
+    X('d', double)
+
+// Returns whether `objCType` is one of ZTSQLITE_SCALAR_TYPES.
+static BOOL ZTSQLiteIsScalarObjCType(const char *objCType) {
+    return objCType != NULL && objCType[0] != '\0' && objCType[1] == '\0' && strchr("cBsilqCSILQfd", objCType[0]) != NULL;
+}
+
+// Reads the value of a column of the current row of `statement` the way FMDB
+// boxes it into a result dictionary.
 //
-// Returns a SQLite adapter for modelClass, creating one of necessary. If no
-// adapter could be created, nil is returned.
-- (ZTSQLiteAdapter *)SQLiteAdapterForModelClass:(Class)modelClass error:(NSError **)error;
+// Returns an NSNumber, NSString or NSData, or NSNull for NULL values.
+static id ZTSQLiteStatementColumnValue(sqlite3_stmt *statement, int idx) {
+    switch (sqlite3_column_type(statement, idx)) {
+        case SQLITE_INTEGER:
+            return @(sqlite3_column_int64(statement, idx));
+
+        case SQLITE_FLOAT:
+            return @(sqlite3_column_double(statement, idx));
+
+        case SQLITE_BLOB: {
+            const void *bytes = sqlite3_column_blob(statement, idx);
+            return [NSData dataWithBytes:bytes length:(NSUInteger)sqlite3_column_bytes(statement, idx)];
+        }
 
-// Collect all value transformers needed for a given class.
+        case SQLITE_NULL:
+            return [NSNull null];
+
+        default: {
+            const unsigned char *text = sqlite3_column_text(statement, idx);
+            if (text == NULL) return [NSNull null];
+            return [[NSString alloc] initWithBytes:text length:(NSUInteger)sqlite3_column_bytes(statement, idx) encoding:NSUTF8StringEncoding];
+        }
+    }
+}
+
+// Creates a result dictionary from the current row of `statement`, keyed by
+// column name like -[FMResultSet resultDictionary].
+static NSDictionary *ZTSQLiteResultDictionaryFromStatement(sqlite3_stmt *statement) {
+    int count = sqlite3_column_count(statement);
+    NSMutableDictionary *resultDictionary = [NSMutableDictionary dictionaryWithCapacity:(NSUInteger)count];
+
+    for (int idx = 0; idx < count; idx++) {
+        const char *name = sqlite3_column_name(statement, idx);
+        if (name == NULL) continue;
+
+        resultDictionary[@(name)] = ZTSQLiteStatementColumnValue(statement, idx);
+    }
+
+    return resultDictionary;
+}
+
+// The key of the ZTSQLiteFault associated with lazily decoded models. The
+// fault is cleared by whichever thread resolves the last lazy property, so it
+// is retained atomically.
+static char ZTSQLiteFaultKey;
+
+// Holds the raw column values of the properties of a lazily decoded model
+// that have not been read yet.
+@interface ZTSQLiteFault : NSObject
+
+- (instancetype)initWithAdapter:(ZTSQLiteAdapter *)adapter columnValuesByPropertyKey:(NSMutableDictionary *)columnValuesByPropertyKey;
+
+// The adapter that decoded the model.
+@property (nonatomic, strong, readonly) ZTSQLiteAdapter *adapter;
+
+// The raw column values of the properties that have not been read yet. Must
+// only be accessed while synchronized on the fault.
+@property (nonatomic, strong, readonly) NSMutableDictionary *columnValuesByPropertyKey;
+
+@end
+
+@implementation ZTSQLiteFault
+
+- (instancetype)initWithAdapter:(ZTSQLiteAdapter *)adapter columnValuesByPropertyKey:(NSMutableDictionary *)columnValuesByPropertyKey {
+    if (self = [super init]) {
+        _adapter = adapter;
+        _columnValuesByPropertyKey = columnValuesByPropertyKey;
+    }
+    return self;
+}
+
+@end
+
+// The key of the ZTSQLiteResidentModelEntry associated with models in an
+// identity map.
+static char ZTSQLiteResidentModelEntryKey;
+
+// Removes the identity map entry of a model once the model is deallocated.
+// Associated with each resident model, so it is released along with the
+// model's other associated objects.
+@interface ZTSQLiteResidentModelEntry : NSObject
+
+- (instancetype)initWithMap:(NSMapTable *)map primaryKey:(NSArray *)primaryKey;
+
+@end
+
+@implementation ZTSQLiteResidentModelEntry {
+    __weak NSMapTable *_map;
+    NSArray *_primaryKey;
+}
+
+- (instancetype)initWithMap:(NSMapTable *)map primaryKey:(NSArray *)primaryKey {
+    if (self = [super init]) {
+        _map = map;
+        _primaryKey = primaryKey;
+    }
+    return self;
+}
+
+- (void)dealloc {
+    NSMapTable *map = _map;
+    if (map == nil) {
+        return;
+    }
+
+    // A deallocating model already reads as nil. Any other model is a newer
+    // one decoded from the same row, which keeps the entry.
+    @synchronized(map) {
+        if ([map objectForKey:_primaryKey] == nil) {
+            [map removeObjectForKey:_primaryKey];
+        }
+    }
+}
+
+@end
+
+// Reads the scalar property described by `column` from `model` without boxing.
+static inline ZTSQLiteScalarValue ZTSQLiteScalarColumnValueOfModel(const ZTSQLiteColumn *column, id model) {
+    ZTSQLiteScalarValue result = { 0 };
+
+    switch (column->scalarType) {
+        #define ZTSQLITE_GET_SCALAR(encoding, type) \
+        case encoding: { \
+            type value = ((type (*)(id, SEL))column->scalarGetterImplementation)(model, column->scalarGetter); \
+            if (column->scalarIsBoolean) { \
+                result.type = SQLITE_INTEGER; \
+                result.integerValue = value != 0; \
+            } else if (encoding == 'f' || encoding == 'd') { \
+                result.type = SQLITE_FLOAT; \
+                result.realValue = (double)value; \
+            } else { \
+                result.type = SQLITE_INTEGER; \
+                result.integerValue = (sqlite3_int64)value; \
+            } \
+            break; \
+        }
+
+        ZTSQLITE_SCALAR_TYPES(ZTSQLITE_GET_SCALAR)
+        #undef ZTSQLITE_GET_SCALAR
+    }
+
+    return result;
+}
+
+// Reads the scalar property described by `column` from `model` and boxes it
+// the way KVC and the default transformers would.
+static inline NSNumber *ZTSQLiteBoxedScalarColumnValueOfModel(const ZTSQLiteColumn *column, id model) {
+    switch (column->scalarType) {
+        #define ZTSQLITE_BOX_SCALAR(encoding, type) \
+        case encoding: { \
+            type value = ((type (*)(id, SEL))column->scalarGetterImplementation)(model, column->scalarGetter); \
+            return column->scalarIsBoolean ? @(value != 0) : @(value); \
+        }
+
+        ZTSQLITE_SCALAR_TYPES(ZTSQLITE_BOX_SCALAR)
+        #undef ZTSQLITE_BOX_SCALAR
+    }
+
+    return nil;
+}
+
+// Sets a raw column value on the scalar property described by `column` of
+// `model`, converting it the way KVC would convert an NSNumber.
+static inline void ZTSQLiteSetScalarColumnValueOfModel(const ZTSQLiteColumn *column, id model, ZTSQLiteScalarValue value) {
+    switch (column->scalarType) {
+        #define ZTSQLITE_SET_SCALAR(encoding, type) \
+        case encoding: { \
+            type scalar; \
+            if (column->scalarIsBoolean) { \
+                scalar = (type)(value.type == SQLITE_INTEGER ? value.integerValue != 0 : value.realValue != 0); \
+            } else { \
+                scalar = value.type == SQLITE_INTEGER ? (type)value.integerValue : (type)value.realValue; \
+            } \
+            ((void (*)(id, SEL, type))column->scalarSetterImplementation)(model, column->scalarSetter, scalar); \
+            break; \
+        }
+
+        ZTSQLITE_SCALAR_TYPES(ZTSQLITE_SET_SCALAR)
+        #undef ZTSQLITE_SET_SCALAR
+    }
+}
+
+// Reads a column of the current row of `statement` without boxing it.
 //
-// modelClass - The class from which to parse the SQLite result dictionary. This class must conform
-//              to <ZTSQLiteSerializing>. This argument must not be nil.
+// Returns a raw value, whose type is 0 unless the column holds an INTEGER or
+// REAL value.
+static inline ZTSQLiteScalarValue ZTSQLiteStatementScalarColumnValue(sqlite3_stmt *statement, int idx) {
+    ZTSQLiteScalarValue result = { 0 };
+
+    switch (sqlite3_column_type(statement, idx)) {
+        case SQLITE_INTEGER:
+            result.type = SQLITE_INTEGER;
+            result.integerValue = sqlite3_column_int64(statement, idx);
+            break;
+
+        case SQLITE_FLOAT:
+            result.type = SQLITE_FLOAT;
+            result.realValue = sqlite3_column_double(statement, idx);
+            break;
+    }
+
+    return result;
+}
+
+// Binds a parameter value the way FMDB binds objects.
 //
-// Returns a dictionary with the properties of modelClass that need
-// transformation as keys and the value transformers as values.
-+ (NSDictionary *)valueTransformersForModelClass:(Class)modelClass;
+// Returns the result code of the sqlite3_bind_* function.
+static int ZTSQLiteBindParameterValue(sqlite3_stmt *statement, int idx, id value) {
+    if (value == nil || value == [NSNull null]) {
+        return sqlite3_bind_null(statement, idx);
+    }
+
+    if ([value isKindOfClass:NSData.class]) {
+        const void *bytes = [value bytes];
+        if (bytes == NULL) {
+            // A NULL pointer would bind NULL instead of an empty blob.
+            bytes = "";
+        }
+
+        return sqlite3_bind_blob(statement, idx, bytes, (int)[value length], SQLITE_TRANSIENT);
+    }
+
+    if ([value isKindOfClass:NSDate.class]) {
+        return sqlite3_bind_double(statement, idx, [value timeIntervalSince1970]);
+    }
+
+    if ([value isKindOfClass:NSNumber.class]) {
+        const char *objCType = [value objCType];
+
+        if (strcmp(objCType, @encode(float)) == 0 || strcmp(objCType, @encode(double)) == 0) {
+            return sqlite3_bind_double(statement, idx, [value doubleValue]);
+        } else if (strcmp(objCType, @encode(unsigned long long)) == 0) {
+            return sqlite3_bind_int64(statement, idx, (sqlite3_int64)[value unsignedLongLongValue]);
+        } else {
+            return sqlite3_bind_int64(statement, idx, [value longLongValue]);
+        }
+    }
+
+    return sqlite3_bind_text(statement, idx, [[value description] UTF8String], -1, SQLITE_TRANSIENT);
+}
+
+// Holds raw rows stepped from a statement while streaming models, and the
+// models deserialized from them.
+@interface ZTSQLiteRowChunk : NSObject
+
+- (instancetype)initWithNumber:(NSUInteger)number firstRowIndex:(NSUInteger)firstRowIndex columnCount:(NSUInteger)columnCount;
+
+// The position of the chunk in the stream.
+@property (nonatomic, assign, readonly) NSUInteger number;
+
+// The row index of the first row of the chunk.
+@property (nonatomic, assign, readonly) NSUInteger firstRowIndex;
+
+// The number of rows in the chunk, up to ZTSQLiteAdapterStreamChunkSize.
+@property (nonatomic, assign) NSUInteger rowCount;
+
+// The result dictionaries of the rows, for model classes that need them to
+// choose the class of a row.
+@property (nonatomic, strong, readonly) NSMutableArray *resultDictionaries;
+
+// The models deserialized from the rows, up to the first row that failed.
+@property (nonatomic, strong, readonly) NSMutableArray *models;
+
+// The error of the first row that failed to deserialize, or nil.
+@property (nonatomic, strong) NSError *error;
+
+// Returns the buffer of `columnCount` raw column values of a row.
+- (__strong id *)columnValuesOfRowAtIndex:(NSUInteger)rowIdx;
+
+// Returns the buffer of `columnCount` unboxed column values of a row.
+- (ZTSQLiteScalarValue *)scalarValuesOfRowAtIndex:(NSUInteger)rowIdx;
 
 @end
 
-@implementation ZTSQLiteAdapter
+@implementation ZTSQLiteRowChunk {
+    NSUInteger _columnCount;
+    __strong id *_columnValues;
+    ZTSQLiteScalarValue *_scalarValues;
+}
 
-+ (id)modelOfClass:(Class)modelClass fromResultDictionary:(NSDictionary *)resultDictionary error:(NSError *__autoreleasing *)error {
-    ZTSQLiteAdapter *adapter = [[self alloc] initWithModelClass:modelClass];
-    return [adapter modelFromResultDictionary:resultDictionary error:error];
+- (instancetype)initWithNumber:(NSUInteger)number firstRowIndex:(NSUInteger)firstRowIndex columnCount:(NSUInteger)columnCount {
+    if (self = [super init]) {
+        _number = number;
+        _firstRowIndex = firstRowIndex;
+        _columnCount = MAX(columnCount, 1);
+        _columnValues = (__strong id *)calloc(ZTSQLiteAdapterStreamChunkSize * _columnCount, sizeof(id));
+        _scalarValues = calloc(ZTSQLiteAdapterStreamChunkSize * _columnCount, sizeof(ZTSQLiteScalarValue));
+        _resultDictionaries = [NSMutableArray array];
+        _models = [NSMutableArray arrayWithCapacity:ZTSQLiteAdapterStreamChunkSize];
+    }
+    return self;
 }
 
-+ (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model insertingIntoTable:(NSString *)tableName
-                                     statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
-    ZTSQLiteAdapter *adapter = [[self alloc] initWithModelClass:model.class];
-    return [adapter parameterDictionaryFromModel:model insertingIntoTable:tableName statement:statement error:error];
+- (void)dealloc {
+    for (NSUInteger idx = 0; idx < ZTSQLiteAdapterStreamChunkSize * _columnCount; idx++) {
+        _columnValues[idx] = nil;
+    }
+    free(_columnValues);
+    free(_scalarValues);
 }
 
-+ (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model updatingInTable:(NSString *)tableName
-                                     statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
-    ZTSQLiteAdapter *adapter = [[self alloc] initWithModelClass:model.class];
-    return [adapter parameterDictionaryFromModel:model updatingInTable:tableName statement:statement error:error];
+- (__strong id *)columnValuesOfRowAtIndex:(NSUInteger)rowIdx {
+    return _columnValues + rowIdx * _columnCount;
 }
 
-+ (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model deletingFromTable:(NSString *)tableName
-                                     statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
-    ZTSQLiteAdapter *adapter = [[self alloc] initWithModelClass:model.class];
-    return [adapter parameterDictionaryFromModel:model deletingFromTable:tableName statement:statement error:error];
+- (ZTSQLiteScalarValue *)scalarValuesOfRowAtIndex:(NSUInteger)rowIdx {
+    return _scalarValues + rowIdx * _columnCount;
+}
+
+@end
+
+// The result columns of a statement resolved against the column plan by
+// -getColumnIndexes:ofStatement:projection:. Instances are immutable.
+@interface ZTSQLiteResolvedColumns : NSObject
+
+- (instancetype)initWithStatement:(sqlite3_stmt *)statement projection:(NSIndexSet *)projection columnIndexes:(const int *)columnIndexes columnCount:(NSUInteger)columnCount;
+
+// Whether the receiver was resolved for `statement` and `projection`.
+//
+// Statements are identified by their pointer and SQL, since a finalized
+// statement's pointer may be reused by a newly prepared one.
+- (BOOL)matchesStatement:(sqlite3_stmt *)statement projection:(NSIndexSet *)projection;
+
+// Copies the `columnCount` resolved column indexes into `columnIndexes`.
+- (void)getColumnIndexes:(int *)columnIndexes;
+
+@end
+
+@implementation ZTSQLiteResolvedColumns {
+    sqlite3_stmt *_statement;
+    char *_SQL;
+    int _resultColumnCount;
+    NSIndexSet *_projection;
+    int *_columnIndexes;
+    NSUInteger _columnCount;
+}
+
+- (instancetype)initWithStatement:(sqlite3_stmt *)statement projection:(NSIndexSet *)projection columnIndexes:(const int *)columnIndexes columnCount:(NSUInteger)columnCount {
+    if (self = [super init]) {
+        _statement = statement;
+        _SQL = strdup(sqlite3_sql(statement) ?: "");
+        _resultColumnCount = sqlite3_column_count(statement);
+        _projection = projection;
+        _columnCount = columnCount;
+        _columnIndexes = calloc(MAX(columnCount, 1), sizeof(int));
+        memcpy(_columnIndexes, columnIndexes, columnCount * sizeof(int));
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free(_SQL);
+    free(_columnIndexes);
+}
+
+- (BOOL)matchesStatement:(sqlite3_stmt *)statement projection:(NSIndexSet *)projection {
+    if (statement != _statement) return NO;
+    if (projection != _projection && ![projection isEqualToIndexSet:_projection]) return NO;
+    if (sqlite3_column_count(statement) != _resultColumnCount) return NO;
+
+    return strcmp(sqlite3_sql(statement) ?: "", _SQL) == 0;
+}
+
+- (void)getColumnIndexes:(int *)columnIndexes {
+    memcpy(columnIndexes, _columnIndexes, _columnCount * sizeof(int));
+}
+
+@end
+
+// Reads the value of the property described by `column` from `model`.
+//
+// Returns the property value, which may be nil.
+static inline id ZTSQLiteColumnValueOfModel(const ZTSQLiteColumn *column, id model) {
+    if (column->getterImplementation != NULL) {
+        return ((id (*)(id, SEL))column->getterImplementation)(model, column->getter);
+    }
+
+    return [model valueForKey:column->propertyKey];
+}
+
+// Serializes the property described by `column` of `model` into a parameter
+// value.
+//
+// Returns the parameter value, which is NSNull instead of nil, or nil if the
+// transformer failed. In that case `error` may be set.
+static inline id ZTSQLiteParameterValueOfModel(const ZTSQLiteColumn *column, id model, NSError **error) {
+    // A lazy property that was never read still has its column value.
+    if (column->lazy) {
+        ZTSQLiteFault *fault = objc_getAssociatedObject(model, &ZTSQLiteFaultKey);
+        if (fault != nil) {
+            @synchronized(fault) {
+                id columnValue = fault.columnValuesByPropertyKey[column->propertyKey];
+                if (columnValue != nil) {
+                    return columnValue;
+                }
+            }
+        }
+    }
+
+    if (column->scalarType != 0) {
+        return ZTSQLiteBoxedScalarColumnValueOfModel(column, model);
+    }
+
+    id value = ZTSQLiteColumnValueOfModel(column, model);
+
+    if (column->transformerAllowsReverseTransformation) {
+        if (column->reverseTransformerHandlesErrors) {
+            id<MTLTransformerErrorHandling> errorHandlingTransformer = (id)column->transformer;
+
+            BOOL success = YES;
+            value = [errorHandlingTransformer reverseTransformedValue:value success:&success error:error];
+            if (!success) {
+                return nil;
+            }
+        } else {
+            value = [column->transformer reverseTransformedValue:value];
+        }
+    }
+
+    return value ?: [NSNull null];
+}
+
+// Deserializes a raw column value with the transformer of `column`.
+//
+// Returns the property value, which is NSNull instead of nil. If the
+// transformer failed, `success` is set to NO and `error` may be set.
+static inline id ZTSQLiteTransformedColumnValue(const ZTSQLiteColumn *column, id value, BOOL *success, NSError **error) {
+    NSValueTransformer *transformer = column->transformer;
+    if (!transformer) {
+        return value;
+    }
+
+    // Map NSNull -> nil for the transformer, and then back for the
+    // dictionary we're going to insert into.
+    if (value == [NSNull null]) {
+        value = nil;
+    }
+
+    if (column->transformerHandlesErrors) {
+        id<MTLTransformerErrorHandling> errorHandlingTransformer = (id)transformer;
+        value = [errorHandlingTransformer transformedValue:value success:success error:error];
+    } else {
+        value = [transformer transformedValue:value];
+    }
+
+    return value ?: [NSNull null];
+}
+
+// Sets the decoded `value` of `column` on `model` like -setValue:forKey:
+// would, calling the setter found when the adapter was initialized if there is
+// one. NSNull is set as nil.
+static inline void ZTSQLiteSetColumnValueOfModel(const ZTSQLiteColumn *column, id model, id value) {
+    if (value == [NSNull null]) {
+        value = nil;
+    }
+
+    if (column->setterImplementation != NULL) {
+        ((void (*)(id, SEL, id))column->setterImplementation)(model, column->setter, value);
+    } else {
+        [model setValue:value forKey:column->propertyKey];
+    }
+}
+
+// The kind of a SQLite statement generated by an adapter.
+typedef NS_ENUM(NSInteger, ZTSQLiteStatementOperation) {
+    ZTSQLiteStatementOperationInsert,
+    ZTSQLiteStatementOperationUpdate,
+    ZTSQLiteStatementOperationDelete,
+
+    // An INSERT that updates the existing row if the primary key conflicts.
+    ZTSQLiteStatementOperationUpsert,
+
+    // A SELECT of the mapped columns.
+    ZTSQLiteStatementOperationSelect,
+
+    // A SELECT of the mapped columns of the row with a given primary key.
+    ZTSQLiteStatementOperationSelectByPrimaryKey,
+};
+
+// Identifies a generated statement in the statement cache of an adapter.
+@interface ZTSQLiteStatementKey : NSObject <NSCopying>
+
+- (instancetype)initWithOperation:(ZTSQLiteStatementOperation)operation tableName:(NSString *)tableName columnIndexes:(NSIndexSet *)columnIndexes rowCount:(NSUInteger)rowCount positional:(BOOL)positional;
+
+- (instancetype)initWithOperation:(ZTSQLiteStatementOperation)operation tableName:(NSString *)tableName columnIndexes:(NSIndexSet *)columnIndexes conflictUpdateColumnIndexes:(NSIndexSet *)conflictUpdateColumnIndexes rowCount:(NSUInteger)rowCount positional:(BOOL)positional;
+
+- (instancetype)initWithOperation:(ZTSQLiteStatementOperation)operation tableName:(NSString *)tableName columnIndexes:(NSIndexSet *)columnIndexes whereClause:(NSString *)whereClause positional:(BOOL)positional;
+
+@property (nonatomic, assign, readonly) ZTSQLiteStatementOperation operation;
+@property (nonatomic, copy, readonly) NSString *tableName;
+
+// The indexes in the column plan of the columns the statement writes.
+@property (nonatomic, copy, readonly) NSIndexSet *columnIndexes;
+
+// The indexes in the column plan of the columns an upsert assigns when the
+// primary key conflicts, nil for other statements.
+@property (nonatomic, copy, readonly) NSIndexSet *conflictUpdateColumnIndexes;
+
+// The number of rows written by a multi-row statement, 1 otherwise.
+@property (nonatomic, assign, readonly) NSUInteger rowCount;
+
+// Whether the statement uses `?` placeholders instead of `:column` ones.
+@property (nonatomic, assign, readonly, getter = isPositional) BOOL positional;
+
+// The caller-supplied WHERE clause of a SELECT, nil for other statements.
+@property (nonatomic, copy, readonly) NSString *whereClause;
+
+@end
+
+@implementation ZTSQLiteStatementKey {
+    NSUInteger _hash;
+}
+
+- (instancetype)initWithOperation:(ZTSQLiteStatementOperation)operation tableName:(NSString *)tableName columnIndexes:(NSIndexSet *)columnIndexes rowCount:(NSUInteger)rowCount positional:(BOOL)positional {
+    return [self initWithOperation:operation tableName:tableName columnIndexes:columnIndexes conflictUpdateColumnIndexes:nil rowCount:rowCount positional:positional];
+}
+
+- (instancetype)initWithOperation:(ZTSQLiteStatementOperation)operation tableName:(NSString *)tableName columnIndexes:(NSIndexSet *)columnIndexes whereClause:(NSString *)whereClause positional:(BOOL)positional {
+    if (self = [self initWithOperation:operation tableName:tableName columnIndexes:columnIndexes conflictUpdateColumnIndexes:nil rowCount:1 positional:positional]) {
+        _whereClause = [whereClause copy];
+        _hash = _hash * 31 + _whereClause.hash;
+    }
+    return self;
+}
+
+- (instancetype)initWithOperation:(ZTSQLiteStatementOperation)operation tableName:(NSString *)tableName columnIndexes:(NSIndexSet *)columnIndexes conflictUpdateColumnIndexes:(NSIndexSet *)conflictUpdateColumnIndexes rowCount:(NSUInteger)rowCount positional:(BOOL)positional {
+    if (self = [super init]) {
+        _operation = operation;
+        _tableName = [tableName copy];
+        _columnIndexes = [columnIndexes copy];
+        _conflictUpdateColumnIndexes = [conflictUpdateColumnIndexes copy];
+        _rowCount = rowCount;
+        _positional = positional;
+
+        __block NSUInteger hash = (((NSUInteger)operation ^ _tableName.hash) * 31 + rowCount) * 2 + (positional ? 1 : 0);
+        [_columnIndexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+            hash = hash * 31 + idx;
+        }];
+        [_conflictUpdateColumnIndexes enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL *stop) {
+            hash = hash * 37 + idx;
+        }];
+        _hash = hash;
+    }
+    return self;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    return self;
+}
+
+- (NSUInteger)hash {
+    return _hash;
+}
+
+- (BOOL)isEqual:(ZTSQLiteStatementKey *)other {
+    if (self == other) return YES;
+    if (![other isKindOfClass:ZTSQLiteStatementKey.class]) return NO;
+
+    return _hash == other->_hash
+        && self.operation == other.operation
+        && self.rowCount == other.rowCount
+        && self.positional == other.positional
+        && [self.tableName isEqualToString:other.tableName]
+        && [self.columnIndexes isEqualToIndexSet:other.columnIndexes]
+        && (self.conflictUpdateColumnIndexes == other.conflictUpdateColumnIndexes || [self.conflictUpdateColumnIndexes isEqualToIndexSet:other.conflictUpdateColumnIndexes])
+        && (self.whereClause == other.whereClause || [self.whereClause isEqualToString:other.whereClause]);
+}
+
+@end
+
+#if ZTSQLITE_INSTRUMENTATION
+
+static const NSUInteger ZTSQLiteInstrumentationEventCount = ZTSQLiteInstrumentationEventClassClusterRedirect + 1;
+
+// The statistics of one event, updated with relaxed atomics.
+typedef struct {
+    _Atomic(uint64_t) count;
+    _Atomic(uint64_t) totalNanoseconds;
+    _Atomic(uint64_t) histogram[ZTSQLiteInstrumentationHistogramBucketCount];
+} ZTSQLiteAtomicInstrumentationStatistics;
+
+// An instrumentation callback and its context, published together.
+typedef struct ZTSQLiteInstrumentationCallbackEntry {
+    ZTSQLiteInstrumentationCallback function;
+    void *context;
+
+    // The next replaced entry waiting to be freed.
+    struct ZTSQLiteInstrumentationCallbackEntry *next;
+} ZTSQLiteInstrumentationCallbackEntry;
+
+// Whether statistics are recorded or a callback is set. This is the only
+// thing checked by disabled instrumentation.
+static atomic_bool ZTSQLiteInstrumentationActive = false;
+
+// Whether +recordsInstrumentation returns YES.
+static atomic_bool ZTSQLiteInstrumentationRecording = false;
+
+// The published callback entry, or NULL.
+static _Atomic(ZTSQLiteInstrumentationCallbackEntry *) ZTSQLiteInstrumentationCallbackSnapshot = NULL;
+
+// The number of events being reported to a callback. Readers register before
+// loading the published entry, so replaced entries can be freed whenever no
+// reader is registered after the replacement.
+static atomic_ulong ZTSQLiteInstrumentationCallbackReaderCount = 0;
+
+// Replaced callback entries a reader may still use. Must only be accessed
+// while synchronized on ZTSQLiteAdapter.
+static ZTSQLiteInstrumentationCallbackEntry *ZTSQLiteRetiredInstrumentationCallbackEntries = NULL;
+
+// Returns the start time of an instrumented phase, or 0 if instrumentation
+// is disabled.
+static inline uint64_t ZTSQLiteInstrumentationStartTime(void) {
+    return atomic_load_explicit(&ZTSQLiteInstrumentationActive, memory_order_relaxed) ? mach_absolute_time() : 0;
+}
+
+// Records an event in `statistics` and reports it to the callback.
+//
+// startTime - The start time of a timed event, or 0.
+static void ZTSQLiteInstrumentationRecordEvent(ZTSQLiteAtomicInstrumentationStatistics *statistics, Class modelClass, ZTSQLiteInstrumentationEvent event, uint64_t startTime) {
+    uint64_t nanoseconds = 0;
+    if (startTime != 0) {
+        static mach_timebase_info_data_t timebase;
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+            mach_timebase_info(&timebase);
+        });
+
+        nanoseconds = (mach_absolute_time() - startTime) * timebase.numer / timebase.denom;
+    }
+
+    if (atomic_load_explicit(&ZTSQLiteInstrumentationRecording, memory_order_relaxed)) {
+        ZTSQLiteAtomicInstrumentationStatistics *eventStatistics = &statistics[event];
+        atomic_fetch_add_explicit(&eventStatistics->count, 1, memory_order_relaxed);
+
+        if (startTime != 0) {
+            NSUInteger bucket = nanoseconds > 1 ? MIN((NSUInteger)(63 - __builtin_clzll(nanoseconds)), (NSUInteger)ZTSQLiteInstrumentationHistogramBucketCount - 1) : 0;
+
+            atomic_fetch_add_explicit(&eventStatistics->totalNanoseconds, nanoseconds, memory_order_relaxed);
+            atomic_fetch_add_explicit(&eventStatistics->histogram[bucket], 1, memory_order_relaxed);
+        }
+    }
+
+    if (atomic_load_explicit(&ZTSQLiteInstrumentationCallbackSnapshot, memory_order_relaxed) != NULL) {
+        atomic_fetch_add(&ZTSQLiteInstrumentationCallbackReaderCount, 1);
+
+        ZTSQLiteInstrumentationCallbackEntry *callback = atomic_load(&ZTSQLiteInstrumentationCallbackSnapshot);
+        if (callback != NULL) {
+            callback->function(modelClass, event, nanoseconds, callback->context);
+        }
+
+        atomic_fetch_sub_explicit(&ZTSQLiteInstrumentationCallbackReaderCount, 1, memory_order_release);
+    }
+}
+
+static inline void ZTSQLiteInstrumentationEndPhase(ZTSQLiteAtomicInstrumentationStatistics *statistics, Class modelClass, ZTSQLiteInstrumentationEvent event, uint64_t startTime) {
+    if (startTime != 0) {
+        ZTSQLiteInstrumentationRecordEvent(statistics, modelClass, event, startTime);
+    }
+}
+
+static inline void ZTSQLiteInstrumentationCount(ZTSQLiteAtomicInstrumentationStatistics *statistics, Class modelClass, ZTSQLiteInstrumentationEvent event) {
+    if (atomic_load_explicit(&ZTSQLiteInstrumentationActive, memory_order_relaxed)) {
+        ZTSQLiteInstrumentationRecordEvent(statistics, modelClass, event, 0);
+    }
+}
+
+// Instrument the receiving adapter from within its instance methods. They
+// compile to nothing without ZTSQLITE_INSTRUMENTATION.
+#define ZTSQLITE_INSTRUMENT_START(startTime) uint64_t startTime = ZTSQLiteInstrumentationStartTime()
+#define ZTSQLITE_INSTRUMENT_END(event, startTime) ZTSQLiteInstrumentationEndPhase(self->_instrumentationStatistics, self->_modelClass, event, startTime)
+#define ZTSQLITE_INSTRUMENT_COUNT(event) ZTSQLiteInstrumentationCount(self->_instrumentationStatistics, self->_modelClass, event)
+
+#else
+
+#define ZTSQLITE_INSTRUMENT_START(startTime)
+#define ZTSQLITE_INSTRUMENT_END(event, startTime)
+#define ZTSQLITE_INSTRUMENT_COUNT(event)
+
+#endif
+
+@interface ZTSQLiteAdapter () {
+    // The column plan, one entry per mapped property key, sorted by property key.
+    ZTSQLiteColumn *_columns;
+    NSUInteger _columnCount;
+
+    // The number of models decoded under ZTSQLiteValidationPolicySampled.
+    _Atomic(NSUInteger) _sampledModelCount;
+
+    // The published snapshot of the projection cache, an NSDictionary mapping
+    // property keys to the return values of -projectionForPropertyKeys:.
+    // Published dictionaries are never mutated, so readers only need an
+    // acquire load of this pointer.
+    _Atomic(void *) _projectionCacheSnapshot;
+
+#if ZTSQLITE_INSTRUMENTATION
+    // The aggregated statistics, one entry per ZTSQLiteInstrumentationEvent.
+    ZTSQLiteAtomicInstrumentationStatistics *_instrumentationStatistics;
+#endif
+}
+
+// The MTLModel subclass being parsed, or the class of `model` if parsing has
+// completed.
+@property (nonatomic, strong, readonly) Class modelClass;
+
+// A cached copy of the return value of +SQLiteColumnNamesByPropertyKey.
+@property (nonatomic, copy, readonly) NSDictionary *SQLiteColumnNamesByPropertyKey;
+
+// A cached copy of the return value of -valueTransformersForModelClass:
+@property (nonatomic, copy, readonly) NSDictionary *valueTransformersByPropertyKey;
+
+// The mapped property keys in column plan order. Owns the keys referenced by
+// the column plan.
+@property (nonatomic, copy, readonly) NSArray *propertyKeysInColumnOrder;
+
+// All property keys mapped by +SQLiteColumnNamesByPropertyKey.
+@property (nonatomic, copy, readonly) NSSet *mappedPropertyKeys;
+
+// The column plan indexes of the keys returned by +propertyKeysForPrimaryKeys,
+// or nil if the model class does not implement it.
+@property (nonatomic, copy, readonly) NSIndexSet *primaryKeyColumnIndexes;
+
+// The column names of the primary key columns in plan order.
+@property (nonatomic, copy, readonly) NSArray *primaryKeyColumnNames;
+
+// Caches the statements returned by -statementForOperation:tableName:columnIndexes:.
+@property (nonatomic, strong, readonly) NSMutableDictionary *statementsByKey;
+
+// Whether the model class implements +classForParsingResultDictionary:.
+@property (nonatomic, assign, readonly) BOOL parsesClassFromResultDictionary;
+
+// The indexes of all columns in the column plan.
+@property (nonatomic, copy, readonly) NSIndexSet *allColumnIndexes;
+
+// Whether no two mapped properties share a column name.
+@property (nonatomic, assign, readonly) BOOL columnNamesAreUnique;
+
+// The projections computed since the projection cache was last published.
+// Must only be accessed while synchronized on the dictionary, which also
+// serializes publishing.
+@property (nonatomic, strong, readonly) NSMutableDictionary *pendingProjections;
+
+// Keeps every published projection cache alive, since a reader may still use
+// a replaced one. Must only be accessed while synchronized on
+// `pendingProjections`.
+@property (nonatomic, strong, readonly) NSMutableArray *retiredProjectionCaches;
+
+// The result columns resolved for the statement last passed to
+// -modelFromStatement:propertyKeys:error:, so that stepping through a
+// statement one row at a time only resolves them once. Atomic, since the
+// adapter may decode on several threads at once.
+@property (atomic, strong) ZTSQLiteResolvedColumns *lastResolvedColumns;
+
+// Whether +tracksSQLiteChanges of the model class returns YES.
+@property (nonatomic, assign, readonly) BOOL tracksChanges;
+
+// Whether +usesSQLiteIdentityMap of the model class returns YES.
+@property (nonatomic, assign, readonly) BOOL usesIdentityMap;
+
+// Maps the primary key column values of decoded models to the models, which
+// are held weakly. Entries are removed once their model is deallocated. Must
+// only be accessed while synchronized on the map.
+@property (nonatomic, strong, readonly) NSMapTable *residentModelsByPrimaryKey;
+
+// The column plan indexes of the properties decoded on first access.
+@property (nonatomic, copy, readonly) NSIndexSet *lazyColumnIndexes;
+
+// The runtime subclass of the model class that decodes lazy properties on
+// first access, or Nil if no property is decoded lazily.
+@property (nonatomic, strong, readonly) Class faultingModelClass;
+
+// Whether decoded values can be assigned to a newly initialized model instead
+// of going through +[MTLModel modelWithDictionary:error:].
+@property (nonatomic, assign, readonly) BOOL assignsPropertiesDirectly;
+
+// If +classForParsingResultDictionary: returns a model class different from the
+// one this adapter was initialized with, use this method to obtain a shared
+// instance of a suitable adapter from +adapterForModelClass: instead.
+//
+// modelClass - The class from which to parse the result dictionary. This class must conform
+//              to <ZTSQLiteSerializing>. This argument must not be nil.
+// error -      If not NULL, this may be set to an error that occurs during
+//              initializing the adapter.
+//
+// Returns a SQLite adapter for modelClass, creating one of necessary. If no
+// adapter could be created, nil is returned.
+- (ZTSQLiteAdapter *)SQLiteAdapterForModelClass:(Class)modelClass error:(NSError **)error;
+
+// Collect all value transformers needed for a given class.
+//
+// modelClass - The class from which to parse the SQLite result dictionary. This class must conform
+//              to <ZTSQLiteSerializing>. This argument must not be nil.
+//
+// Returns a dictionary with the properties of modelClass that need
+// transformation as keys and the value transformers as values.
++ (NSDictionary *)valueTransformersForModelClass:(Class)modelClass;
+
+@end
+
+@implementation ZTSQLiteAdapter
+
++ (id)modelOfClass:(Class)modelClass fromResultDictionary:(NSDictionary *)resultDictionary error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:modelClass];
+    return [adapter modelFromResultDictionary:resultDictionary error:error];
+}
+
++ (id)modelOfClass:(Class)modelClass fromStatement:(sqlite3_stmt *)statement error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:modelClass];
+    return [adapter modelFromStatement:statement error:error];
+}
+
++ (NSArray *)modelsOfClass:(Class)modelClass fromResultDictionaries:(NSArray *)resultDictionaries error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:modelClass];
+    return [adapter modelsFromResultDictionaries:resultDictionaries errorsByIndex:NULL error:error];
+}
+
++ (NSArray *)modelsOfClass:(Class)modelClass concurrentlyFromResultDictionaries:(NSArray *)resultDictionaries error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:modelClass];
+    return [adapter modelsConcurrentlyFromResultDictionaries:resultDictionaries propertyKeys:nil errorsByIndex:NULL error:error];
+}
+
++ (NSArray *)modelsOfClass:(Class)modelClass fromStatement:(sqlite3_stmt *)statement error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:modelClass];
+    return [adapter modelsFromStatement:statement errorsByIndex:NULL error:error];
+}
+
++ (BOOL)enumerateModelsOfClass:(Class)modelClass fromStatement:(sqlite3_stmt *)statement usingBlock:(void (^)(id, NSUInteger, BOOL *))block error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:modelClass];
+    return [adapter enumerateModelsFromStatement:statement propertyKeys:nil usingBlock:block error:error];
+}
+
++ (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model insertingIntoTable:(NSString *)tableName
+                                     statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:model.class];
+    return [adapter parameterDictionaryFromModel:model insertingIntoTable:tableName statement:statement error:error];
+}
+
++ (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model updatingInTable:(NSString *)tableName
+                                     statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:model.class];
+    return [adapter parameterDictionaryFromModel:model updatingInTable:tableName statement:statement error:error];
+}
+
++ (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model deletingFromTable:(NSString *)tableName
+                                     statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:model.class];
+    return [adapter parameterDictionaryFromModel:model deletingFromTable:tableName statement:statement error:error];
+}
+
++ (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model upsertingIntoTable:(NSString *)tableName
+                                      statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:model.class];
+    return [adapter parameterDictionaryFromModel:model upsertingIntoTable:tableName statement:statement error:error];
+}
+
++ (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model selectingFromTable:(NSString *)tableName
+                                      statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:model.class];
+    return [adapter parameterDictionaryFromModel:model selectingFromTable:tableName statement:statement error:error];
+}
+
++ (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model insertingIntoTable:(NSString *)tableName
+                           statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:model.class];
+    return [adapter parameterArrayFromModel:model insertingIntoTable:tableName statement:statement error:error];
+}
+
++ (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model updatingInTable:(NSString *)tableName
+                           statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:model.class];
+    return [adapter parameterArrayFromModel:model updatingInTable:tableName statement:statement error:error];
+}
+
++ (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model deletingFromTable:(NSString *)tableName
+                           statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:model.class];
+    return [adapter parameterArrayFromModel:model deletingFromTable:tableName statement:statement error:error];
+}
+
++ (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model selectingFromTable:(NSString *)tableName
+                           statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:model.class];
+    return [adapter parameterArrayFromModel:model selectingFromTable:tableName statement:statement error:error];
+}
+
++ (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model upsertingIntoTable:(NSString *)tableName
+                           statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:model.class];
+    return [adapter parameterArrayFromModel:model upsertingIntoTable:tableName statement:statement error:error];
+}
+
++ (NSArray *)parameterArraysFromModels:(NSArray *)models insertingIntoTable:(NSString *)tableName
+                             statements:(NSArray *__autoreleasing *)statements error:(NSError *__autoreleasing *)error {
+    if (models.count == 0) {
+        if (statements) {
+            *statements = @[];
+        }
+        return @[];
+    }
+
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:[models.firstObject class]];
+    return [adapter parameterArraysFromModels:models insertingIntoTable:tableName statements:statements error:error];
+}
+
++ (NSArray *)parameterArraysFromModels:(NSArray *)models upsertingIntoTable:(NSString *)tableName
+                             statements:(NSArray *__autoreleasing *)statements error:(NSError *__autoreleasing *)error {
+    if (models.count == 0) {
+        if (statements) {
+            *statements = @[];
+        }
+        return @[];
+    }
+
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:[models.firstObject class]];
+    return [adapter parameterArraysFromModels:models upsertingIntoTable:tableName statements:statements error:error];
+}
+
++ (NSArray *)parameterArraysFromModels:(NSArray *)models deletingFromTable:(NSString *)tableName
+                             statements:(NSArray *__autoreleasing *)statements error:(NSError *__autoreleasing *)error {
+    if (models.count == 0) {
+        if (statements) {
+            *statements = @[];
+        }
+        return @[];
+    }
+
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:[models.firstObject class]];
+    return [adapter parameterArraysFromModels:models deletingFromTable:tableName statements:statements error:error];
+}
+
++ (NSString *)statementForModelsOfClass:(Class)modelClass selectingFromTable:(NSString *)tableName where:(NSString *)whereClause {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:modelClass];
+    return [adapter statementSelectingFromTable:tableName where:whereClause];
+}
+
++ (BOOL)bindParametersOfStatement:(sqlite3_stmt *)statement fromModel:(id<ZTSQLiteSerializing>)model error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:model.class];
+    return [adapter bindParametersOfStatement:statement fromModel:model error:error];
+}
+
++ (BOOL)didPersistModel:(id<ZTSQLiteSerializing>)model error:(NSError *__autoreleasing *)error {
+    ZTSQLiteAdapter *adapter = [self adapterForModelClass:model.class];
+    return [adapter didPersistModel:model error:error];
+}
+
++ (BOOL)bindParameters:(NSArray *)parameters toStatement:(sqlite3_stmt *)statement error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(parameters);
+    NSParameterAssert(statement != NULL);
+    NSParameterAssert(parameters.count <= (NSUInteger)sqlite3_bind_parameter_count(statement));
+
+    int parameterIdx = 1;
+    for (id value in parameters) {
+        int resultCode = ZTSQLiteBindParameterValue(statement, parameterIdx++, value);
+
+        if (resultCode != SQLITE_OK) {
+            if (error) {
+                *error = ZTSQLiteAdapterStatementFailedError(sqlite3_db_handle(statement), resultCode);
+            }
+            return NO;
+        }
+    }
+
+    return YES;
+}
+
++ (NSString *)columnDefinitionsOfClass:(Class)modelClass
+{
+    NSParameterAssert(modelClass);
+    NSParameterAssert([modelClass conformsToProtocol:@protocol(ZTSQLiteSerializing)]);
+
+    if (![modelClass respondsToSelector:@selector(SQLiteColumnDefinitionsByPropertyKey)]) {
+        return nil;
+    }
+
+    __block NSMutableString *defs = nil;
+    NSDictionary *columnDefinitionsByPropertyKey = [modelClass SQLiteColumnDefinitionsByPropertyKey];
+    [[modelClass SQLiteColumnNamesByPropertyKey] enumerateKeysAndObjectsUsingBlock:^(NSString* propertyKey, NSString* columnName, BOOL *stop) {
+        if (!defs) {
+            defs = [NSMutableString stringWithFormat:@"(%@", columnName];
+        } else {
+            [defs appendFormat:@", %@", columnName];
+        }
+
+        NSString *def = columnDefinitionsByPropertyKey[propertyKey];
+        if (def) {
+            [defs appendFormat:@" %@", def];
+        }
+    }];
+
+    [defs appendString:@")"];
+    return [defs copy];
+}
+
+// The published adapter registry, an immutable NSDictionary mapping model
+// classes to immutable NSDictionaries mapping adapter classes to adapters.
+// Looking up a published adapter only loads this pointer, without taking a
+// lock.
+static _Atomic(void *) ZTSQLiteAdapterRegistrySnapshot;
+
+// Serializes registering adapters, and guards the statics below.
+static NSObject *ZTSQLiteAdapterRegistryLock = nil;
+
+// Adapters created since the registry was last published, keyed like the
+// registry.
+static NSMutableDictionary *ZTSQLitePendingAdaptersByModelClass = nil;
+static NSUInteger ZTSQLitePendingAdapterCount = 0;
+static NSUInteger ZTSQLitePublishedAdapterCount = 0;
+
+// Keeps every published registry alive, since readers may still be using a
+// replaced one.
+static NSMutableArray *ZTSQLiteRetiredAdapterRegistries = nil;
+
++ (instancetype)adapterForModelClass:(Class)modelClass {
+    NSParameterAssert(modelClass);
+    NSParameterAssert([modelClass conformsToProtocol:@protocol(ZTSQLiteSerializing)]);
+
+    NSDictionary *snapshot = (__bridge NSDictionary *)atomic_load_explicit(&ZTSQLiteAdapterRegistrySnapshot, memory_order_acquire);
+    ZTSQLiteAdapter *result = snapshot[modelClass][self];
+    if (result != nil) {
+        return result;
+    }
+
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        ZTSQLiteAdapterRegistryLock = [[NSObject alloc] init];
+        ZTSQLitePendingAdaptersByModelClass = [NSMutableDictionary dictionary];
+        ZTSQLiteRetiredAdapterRegistries = [NSMutableArray array];
+    });
+
+    @synchronized(ZTSQLiteAdapterRegistryLock) {
+        snapshot = (__bridge NSDictionary *)atomic_load_explicit(&ZTSQLiteAdapterRegistrySnapshot, memory_order_relaxed);
+        result = snapshot[modelClass][self] ?: ZTSQLitePendingAdaptersByModelClass[modelClass][self];
+        if (result != nil) {
+            return result;
+        }
+
+        result = [[self alloc] initWithModelClass:modelClass];
+        if (result == nil) {
+            return nil;
+        }
+
+        NSMutableDictionary *pendingAdapters = ZTSQLitePendingAdaptersByModelClass[modelClass];
+        if (pendingAdapters == nil) {
+            pendingAdapters = [NSMutableDictionary dictionary];
+            ZTSQLitePendingAdaptersByModelClass[(id<NSCopying>)modelClass] = pendingAdapters;
+        }
+        pendingAdapters[(id<NSCopying>)self] = result;
+        ZTSQLitePendingAdapterCount++;
+
+        // Like the projection cache, the registry is only published once the
+        // pending adapters outnumber the published ones, so that all retired
+        // registries together stay smaller than the current one.
+        if (ZTSQLitePendingAdapterCount > ZTSQLitePublishedAdapterCount) {
+            NSMutableDictionary *registry = [snapshot mutableCopy] ?: [NSMutableDictionary dictionary];
+            [ZTSQLitePendingAdaptersByModelClass enumerateKeysAndObjectsUsingBlock:^(id pendingModelClass, NSDictionary *adaptersByClass, BOOL *stop) {
+                NSMutableDictionary *mergedAdapters = [registry[pendingModelClass] mutableCopy] ?: [NSMutableDictionary dictionary];
+                [mergedAdapters addEntriesFromDictionary:adaptersByClass];
+                registry[pendingModelClass] = [mergedAdapters copy];
+            }];
+
+            ZTSQLitePublishedAdapterCount += ZTSQLitePendingAdapterCount;
+            ZTSQLitePendingAdapterCount = 0;
+            [ZTSQLitePendingAdaptersByModelClass removeAllObjects];
+
+            NSDictionary *publishedRegistry = [registry copy];
+            [ZTSQLiteRetiredAdapterRegistries addObject:publishedRegistry];
+            atomic_store_explicit(&ZTSQLiteAdapterRegistrySnapshot, (__bridge void *)publishedRegistry, memory_order_release);
+        }
+
+        return result;
+    }
+}
+
+- (instancetype)initWithModelClass:(Class)modelClass {
+    NSParameterAssert(modelClass);
+    NSParameterAssert([modelClass conformsToProtocol:@protocol(ZTSQLiteSerializing)]);
+
+    if (self = [super init]) {
+        _modelClass = modelClass;
+        _SQLiteColumnNamesByPropertyKey = [[modelClass SQLiteColumnNamesByPropertyKey] copy];
+
+        NSSet *propertyKeys = [self.modelClass propertyKeys];
+        for (NSString *mappedPropertyKey in self.SQLiteColumnNamesByPropertyKey) {
+            if (![propertyKeys containsObject:mappedPropertyKey]) {
+                NSAssert(NO, @"%@ is not a property of %@.", mappedPropertyKey, modelClass);
+                return nil;
+            }
+
+            id value = self.SQLiteColumnNamesByPropertyKey[mappedPropertyKey];
+            if (![value isKindOfClass:NSString.class]) {
+                NSAssert(NO, @"%@ must map to a column name, got: %@.", mappedPropertyKey, value);
+                return nil;
+            }
+        }
+
+        _valueTransformersByPropertyKey = [[self.class valueTransformersForModelClass:modelClass] copy];
+        _propertyKeysInColumnOrder = [self.SQLiteColumnNamesByPropertyKey.allKeys sortedArrayUsingSelector:@selector(compare:)];
+
+        _columnCount = self.propertyKeysInColumnOrder.count;
+        _allColumnIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, _columnCount)];
+        _columns = calloc(MAX(_columnCount, 1), sizeof(ZTSQLiteColumn));
+
+#if ZTSQLITE_INSTRUMENTATION
+        _instrumentationStatistics = calloc(ZTSQLiteInstrumentationEventCount, sizeof(ZTSQLiteAtomicInstrumentationStatistics));
+#endif
+
+        [self.propertyKeysInColumnOrder enumerateObjectsUsingBlock:^(NSString *propertyKey, NSUInteger idx, BOOL *stop) {
+            NSValueTransformer *transformer = self.valueTransformersByPropertyKey[propertyKey];
+
+            ZTSQLiteColumn *column = &_columns[idx];
+            column->propertyKey = propertyKey;
+            column->columnName = self.SQLiteColumnNamesByPropertyKey[propertyKey];
+            column->columnNameUTF8 = strdup(column->columnName.UTF8String);
+            column->transformer = transformer;
+            column->index = idx;
+            column->transformerHandlesErrors = [transformer respondsToSelector:@selector(transformedValue:success:error:)];
+            column->transformerAllowsReverseTransformation = [transformer.class allowsReverseTransformation];
+            column->reverseTransformerHandlesErrors = [transformer respondsToSelector:@selector(reverseTransformedValue:success:error:)];
+
+            objc_property_t property = class_getProperty(modelClass, propertyKey.UTF8String);
+            if (property == NULL) return;
+
+            mtl_propertyAttributes *attributes = mtl_copyPropertyAttributes(property);
+            @onExit {
+                free(attributes);
+            };
+
+            if (attributes != NULL && *(attributes->type) == *(@encode(id))) {
+                column->getter = attributes->getter;
+                column->getterImplementation = class_getMethodImplementation(modelClass, attributes->getter);
+            } else if (attributes != NULL && ZTSQLiteIsScalarObjCType(attributes->type)
+                       && [self.class usesDefaultTransformerForScalarPropertyKey:propertyKey objCType:attributes->type ofModelClass:modelClass]) {
+                column->scalarType = *(attributes->type);
+                column->scalarIsBoolean = strcmp(attributes->type, @encode(BOOL)) == 0;
+                column->scalarGetter = attributes->getter;
+                column->scalarGetterImplementation = class_getMethodImplementation(modelClass, attributes->getter);
+            }
+        }];
+
+        _lazyColumnIndexes = [[self lazyColumnIndexesForModelClass:modelClass] copy];
+        if (_lazyColumnIndexes.count) {
+            _faultingModelClass = [self faultingSubclassOfModelClass:modelClass];
+
+            for (NSUInteger idx = _lazyColumnIndexes.firstIndex; idx != NSNotFound; idx = [_lazyColumnIndexes indexGreaterThanIndex:idx]) {
+                // Serializing must go through the overridden getter.
+                _columns[idx].lazy = YES;
+                _columns[idx].getterImplementation = NULL;
+            }
+        }
+
+        _assignsPropertiesDirectly = [self prepareDirectAssignmentForModelClass:modelClass];
+
+        _mappedPropertyKeys = [NSSet setWithArray:self.propertyKeysInColumnOrder];
+        _columnNamesAreUnique = [NSSet setWithArray:self.SQLiteColumnNamesByPropertyKey.allValues].count == _columnCount;
+
+        if ([modelClass respondsToSelector:@selector(propertyKeysForPrimaryKeys)]) {
+            _primaryKeyColumnIndexes = [[self columnIndexesForPropertyKeys:[modelClass propertyKeysForPrimaryKeys]] copy];
+        }
+
+        NSMutableArray *primaryKeyColumnNames = [NSMutableArray arrayWithCapacity:_primaryKeyColumnIndexes.count];
+        for (NSUInteger idx = _primaryKeyColumnIndexes.firstIndex; idx != NSNotFound; idx = [_primaryKeyColumnIndexes indexGreaterThanIndex:idx]) {
+            [primaryKeyColumnNames addObject:_columns[idx].columnName];
+        }
+        _primaryKeyColumnNames = [primaryKeyColumnNames copy];
+
+        _statementsByKey = [NSMutableDictionary dictionary];
+        _validationPolicy = [modelClass respondsToSelector:@selector(SQLiteValidationPolicy)] ? [modelClass SQLiteValidationPolicy] : ZTSQLiteValidationPolicyAlways;
+        _validationSamplingInterval = [modelClass respondsToSelector:@selector(SQLiteValidationSamplingInterval)] ? MAX([modelClass SQLiteValidationSamplingInterval], (NSUInteger)1) : 100;
+        _pendingProjections = [NSMutableDictionary dictionary];
+        _retiredProjectionCaches = [NSMutableArray array];
+        _parsesClassFromResultDictionary = [modelClass respondsToSelector:@selector(classForParsingResultDictionary:)];
+        _tracksChanges = [modelClass respondsToSelector:@selector(tracksSQLiteChanges)] && [modelClass tracksSQLiteChanges];
+        _usesIdentityMap = _primaryKeyColumnIndexes.count && [modelClass respondsToSelector:@selector(usesSQLiteIdentityMap)] && [modelClass usesSQLiteIdentityMap];
+
+        if (_usesIdentityMap) {
+            _residentModelsByPrimaryKey = [NSMapTable strongToWeakObjectsMapTable];
+        }
+    }
+    return self;
+}
+
+// Returns the column plan indexes of the properties returned by
+// +propertyKeysForLazySQLiteDecoding that can be decoded lazily.
+//
+// Only object-typed properties with a transformer qualify, and only if the
+// model class inherits -validate: from MTLModel, since lazy properties are
+// skipped when validating a decoded model.
+- (NSIndexSet *)lazyColumnIndexesForModelClass:(Class)modelClass {
+    if (![modelClass respondsToSelector:@selector(propertyKeysForLazySQLiteDecoding)]) {
+        return nil;
+    }
+
+    if (![modelClass isSubclassOfClass:MTLModel.class]
+        || [modelClass instanceMethodForSelector:@selector(validate:)] != [MTLModel instanceMethodForSelector:@selector(validate:)]) {
+        return nil;
+    }
+
+    NSSet *lazyPropertyKeys = [modelClass propertyKeysForLazySQLiteDecoding];
+    NSMutableIndexSet *lazyColumnIndexes = [NSMutableIndexSet indexSet];
+
+    for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+        const ZTSQLiteColumn *column = &_columns[idx];
+        if (column->transformer != nil && column->getter != NULL && [lazyPropertyKeys containsObject:column->propertyKey]) {
+            [lazyColumnIndexes addIndex:idx];
+        }
+    }
+
+    return lazyColumnIndexes;
+}
+
+// Returns a runtime subclass of `modelClass` whose lazy property getters
+// decode the property before calling the original getter, and whose lazy
+// property setters discard the column value before calling the original
+// setter, so that a value set before the property is read is kept. The
+// subclass reports `modelClass` as its class.
+//
+// The getters pass column plan indexes to the adapter that decoded the model,
+// and adapter subclasses may map a model class differently. The subclass is
+// therefore created once per adapter class and model class, and shared by the
+// adapters of that class, which use the same column plan for the same model
+// class.
+- (Class)faultingSubclassOfModelClass:(Class)modelClass {
+    static NSObject *lock = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        lock = [[NSObject alloc] init];
+    });
+
+    @synchronized(lock) {
+        NSString *name = [NSString stringWithFormat:@"ZTSQLiteFaulting_%@_%@", NSStringFromClass(self.class), NSStringFromClass(modelClass)];
+        Class subclass = objc_getClass(name.UTF8String);
+        if (subclass != Nil) {
+            return subclass;
+        }
+
+        subclass = objc_allocateClassPair(modelClass, name.UTF8String, 0);
+
+        for (NSUInteger idx = _lazyColumnIndexes.firstIndex; idx != NSNotFound; idx = [_lazyColumnIndexes indexGreaterThanIndex:idx]) {
+            SEL getter = _columns[idx].getter;
+            IMP originalGetter = class_getMethodImplementation(modelClass, getter);
+            NSUInteger columnIndex = idx;
+
+            id (^block)(id) = ^id(id model) {
+                ZTSQLiteFault *fault = objc_getAssociatedObject(model, &ZTSQLiteFaultKey);
+                if (fault != nil) {
+                    [fault.adapter resolveFault:fault ofModel:model columnIndex:columnIndex];
+                }
+
+                return ((id (*)(id, SEL))originalGetter)(model, getter);
+            };
+
+            class_addMethod(subclass, getter, imp_implementationWithBlock(block), "@@:");
+
+            objc_property_t property = class_getProperty(modelClass, _columns[idx].propertyKey.UTF8String);
+            mtl_propertyAttributes *attributes = property != NULL ? mtl_copyPropertyAttributes(property) : NULL;
+            SEL setter = attributes != NULL && !attributes->readonly ? attributes->setter : NULL;
+            free(attributes);
+
+            if (setter == NULL || class_getInstanceMethod(modelClass, setter) == NULL) {
+                continue;
+            }
+
+            IMP originalSetter = class_getMethodImplementation(modelClass, setter);
+
+            void (^setterBlock)(id, id) = ^(id model, id value) {
+                ZTSQLiteFault *fault = objc_getAssociatedObject(model, &ZTSQLiteFaultKey);
+                if (fault != nil) {
+                    [fault.adapter discardFault:fault ofModel:model columnIndex:columnIndex];
+                }
+
+                ((void (*)(id, SEL, id))originalSetter)(model, setter, value);
+            };
+
+            class_addMethod(subclass, setter, imp_implementationWithBlock(setterBlock), "v@:@");
+        }
+
+        Class (^classBlock)(id) = ^Class(id model) {
+            return modelClass;
+        };
+        class_addMethod(subclass, @selector(class), imp_implementationWithBlock(classBlock), "#@:");
+
+        objc_registerClassPair(subclass);
+        return subclass;
+    }
+}
+
+// Looks up the setters KVC would use for the properties in the column plan,
+// and returns whether assigning decoded values that way to a model created
+// with -init yields the same model as +[MTLModel modelWithDictionary:error:].
+//
+// That is the case if the model class inherits the dictionary initializers
+// and -validateValue:forKey:error: and -setValue:forKey: from its
+// superclasses, and implements no -validate<Key>:error: method for any mapped
+// property, which leaves -[MTLModel initWithDictionary:error:] with nothing
+// to do but call -setValue:forKey:.
+//
+// Scalar properties read and written without boxing are set through their
+// setter, if it takes the same scalar type. Other properties without an
+// object-typed setter, like readonly ones, are still set through KVC, which
+// also knows how to set their instance variables.
+- (BOOL)prepareDirectAssignmentForModelClass:(Class)modelClass {
+    if (![modelClass isSubclassOfClass:MTLModel.class]
+        || [modelClass methodForSelector:@selector(modelWithDictionary:error:)] != [MTLModel methodForSelector:@selector(modelWithDictionary:error:)]
+        || [modelClass instanceMethodForSelector:@selector(initWithDictionary:error:)] != [MTLModel instanceMethodForSelector:@selector(initWithDictionary:error:)]
+        || [modelClass instanceMethodForSelector:@selector(validateValue:forKey:error:)] != [NSObject instanceMethodForSelector:@selector(validateValue:forKey:error:)]
+        || [modelClass instanceMethodForSelector:@selector(setValue:forKey:)] != [NSObject instanceMethodForSelector:@selector(setValue:forKey:)]) {
+        return NO;
+    }
+
+    NSMutableArray *capitalizedKeys = [NSMutableArray arrayWithCapacity:_columnCount];
+
+    for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+        NSString *key = _columns[idx].propertyKey;
+        NSString *capitalizedKey = [[key substringToIndex:1].uppercaseString stringByAppendingString:[key substringFromIndex:1]];
+
+        SEL validator = NSSelectorFromString([NSString stringWithFormat:@"validate%@:error:", capitalizedKey]);
+        if ([modelClass instancesRespondToSelector:validator]) {
+            return NO;
+        }
+
+        [capitalizedKeys addObject:capitalizedKey];
+    }
+
+    for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+        ZTSQLiteColumn *column = &_columns[idx];
+
+        for (NSString *format in @[ @"set%@:", @"_set%@:" ]) {
+            SEL setter = NSSelectorFromString([NSString stringWithFormat:format, capitalizedKeys[idx]]);
+            Method method = class_getInstanceMethod(modelClass, setter);
+            if (method == NULL) continue;
+
+            char *argumentType = method_copyArgumentType(method, 2);
+            if (argumentType != NULL && *argumentType == *(@encode(id))) {
+                column->setter = setter;
+                column->setterImplementation = method_getImplementation(method);
+            } else if (argumentType != NULL && column->scalarType != 0 && argumentType[0] == column->scalarType && argumentType[1] == '\0') {
+                column->scalarSetter = setter;
+                column->scalarSetterImplementation = method_getImplementation(method);
+            }
+            free(argumentType);
+
+            // KVC uses the first setter found, whatever its argument type.
+            break;
+        }
+    }
+
+    return YES;
+}
+
+// Returns whether the scalar property `key` of `modelClass` gets one of the
+// transformers +valueTransformersForModelClass: falls back to, which leave
+// NSNumbers untouched except for normalizing BOOLs to 0 or 1. Such properties
+// can be read and written without boxing.
++ (BOOL)usesDefaultTransformerForScalarPropertyKey:(NSString *)key objCType:(const char *)objCType ofModelClass:(Class)modelClass {
+    if ([self methodForSelector:@selector(valueTransformersForModelClass:)] != [ZTSQLiteAdapter methodForSelector:@selector(valueTransformersForModelClass:)]) {
+        return NO;
+    }
+
+    if (ZTSQLiteKeyedColumnTransformerOfModelClass(modelClass, key) != nil
+        || [modelClass respondsToSelector:@selector(SQLiteColumnTransformerForKey:)]) {
+        return NO;
+    }
+
+    NSValueTransformer *transformer = [self transformerForModelPropertiesOfObjCType:objCType];
+    if (transformer == nil) {
+        return YES;
+    }
+
+    return strcmp(objCType, @encode(BOOL)) == 0 && transformer == [NSValueTransformer valueTransformerForName:MTLBooleanValueTransformerName];
+}
+
+// Forgets the column value of the lazy property at `columnIndex` of `model`,
+// which is about to be set, so that neither reading nor serializing the
+// property brings back the decoded value.
+- (void)discardFault:(ZTSQLiteFault *)fault ofModel:(id)model columnIndex:(NSUInteger)columnIndex {
+    @synchronized(fault) {
+        NSMutableDictionary *columnValuesByPropertyKey = fault.columnValuesByPropertyKey;
+        if (columnValuesByPropertyKey[_columns[columnIndex].propertyKey] == nil) {
+            return;
+        }
+
+        [columnValuesByPropertyKey removeObjectForKey:_columns[columnIndex].propertyKey];
+        if (columnValuesByPropertyKey.count == 0) {
+            objc_setAssociatedObject(model, &ZTSQLiteFaultKey, nil, OBJC_ASSOCIATION_RETAIN);
+        }
+    }
+}
+
+// Decodes the lazy property at `columnIndex` of `model` if it hasn't been
+// read yet.
+//
+// Errors can't be reported to the caller of a getter, so they are logged and
+// leave the property nil.
+- (void)resolveFault:(ZTSQLiteFault *)fault ofModel:(id)model columnIndex:(NSUInteger)columnIndex {
+    const ZTSQLiteColumn *column = &_columns[columnIndex];
+
+    @synchronized(fault) {
+        id value = fault.columnValuesByPropertyKey[column->propertyKey];
+        if (value == nil) {
+            return;
+        }
+
+        [fault.columnValuesByPropertyKey removeObjectForKey:column->propertyKey];
+        if (fault.columnValuesByPropertyKey.count == 0) {
+            objc_setAssociatedObject(model, &ZTSQLiteFaultKey, nil, OBJC_ASSOCIATION_RETAIN);
+        }
+
+        NSError *error = nil;
+        @try {
+            BOOL success = YES;
+            id rawValue = value;
+            value = ZTSQLiteTransformedColumnValue(column, rawValue, &success, &error);
+            if (!success) {
+                ZTSQLITE_INSTRUMENT_COUNT(ZTSQLiteInstrumentationEventTransformerFailure);
+                NSLog(@"*** Could not decode column name \"%@\" from: %@, error: %@", column->columnName, rawValue, error);
+                return;
+            }
+
+            if (value == [NSNull null]) {
+                value = nil;
+            }
+
+            if (![model validateValue:&value forKey:column->propertyKey error:&error]) {
+                NSLog(@"*** Could not validate property \"%@\" of %@, error: %@", column->propertyKey, self.modelClass, error);
+                return;
+            }
+
+            [model setValue:value forKey:column->propertyKey];
+        } @catch (NSException *ex) {
+            NSLog(@"*** Caught exception %@ decoding column name \"%@\"", ex, column->columnName);
+
+            // Fail fast in Debug builds.
+            #if DEBUG
+            @throw ex;
+            #endif
+        }
+    }
+}
+
+// Validates a lazily decoded model like -[MTLModel validate:], skipping the
+// properties that have not been decoded yet.
+- (BOOL)validateDecodedPropertiesOfModel:(id)model fault:(ZTSQLiteFault *)fault error:(NSError *__autoreleasing *)error {
+    for (NSString *key in [self.modelClass propertyKeys]) {
+        if (fault.columnValuesByPropertyKey[key] != nil) continue;
+
+        id value = [model valueForKey:key];
+        id validatedValue = value;
+
+        if (![model validateValue:&validatedValue forKey:key error:error]) {
+            return NO;
+        }
+
+        if (validatedValue != value) {
+            [model setValue:validatedValue forKey:key];
+        }
+    }
+
+    return YES;
+}
+
+// Returns the column plan indexes of `propertyKeys`, or nil if `propertyKeys`
+// is nil. The result is cached for each set of property keys.
+- (NSIndexSet *)projectionForPropertyKeys:(NSSet *)propertyKeys {
+    if (propertyKeys == nil) {
+        return nil;
+    }
+
+    NSDictionary *snapshot = (__bridge NSDictionary *)atomic_load_explicit(&_projectionCacheSnapshot, memory_order_acquire);
+    NSIndexSet *projection = snapshot[propertyKeys];
+    if (projection != nil) {
+        return projection;
+    }
+
+    @synchronized(self.pendingProjections) {
+        snapshot = (__bridge NSDictionary *)atomic_load_explicit(&_projectionCacheSnapshot, memory_order_relaxed);
+        projection = snapshot[propertyKeys] ?: self.pendingProjections[propertyKeys];
+        if (projection != nil) {
+            return projection;
+        }
+
+        projection = [[self columnIndexesForPropertyKeys:propertyKeys] copy];
+        self.pendingProjections[[propertyKeys copy]] = projection;
+
+        // Publishing copies the whole cache, and replaced caches stay alive.
+        // Only publishing once the pending projections outnumber the published
+        // ones at least doubles the cache every time, which keeps all retired
+        // caches together smaller than the current one.
+        if (self.pendingProjections.count > snapshot.count) {
+            NSMutableDictionary *projectionCache = [snapshot mutableCopy] ?: [NSMutableDictionary dictionary];
+            [projectionCache addEntriesFromDictionary:self.pendingProjections];
+            [self.pendingProjections removeAllObjects];
+
+            NSDictionary *publishedCache = [projectionCache copy];
+            [self.retiredProjectionCaches addObject:publishedCache];
+            atomic_store_explicit(&_projectionCacheSnapshot, (__bridge void *)publishedCache, memory_order_release);
+        }
+    }
+
+    return projection;
+}
+
+- (NSString *)columnListForPropertyKeys:(NSSet *)propertyKeys {
+    NSIndexSet *projection = [self projectionForPropertyKeys:propertyKeys];
+    return [self columnNamesWithColumnIndexes:projection ?: self.allColumnIndexes];
+}
+
+- (NSString *)statementSelectingFromTable:(NSString *)tableName where:(NSString *)whereClause {
+    return [self statementSelectingPropertyKeys:nil fromTable:tableName where:whereClause];
+}
+
+- (NSString *)statementSelectingPropertyKeys:(NSSet *)propertyKeys fromTable:(NSString *)tableName where:(NSString *)whereClause {
+    NSParameterAssert(tableName);
+
+    NSIndexSet *projection = [self projectionForPropertyKeys:propertyKeys];
+    ZTSQLiteStatementKey *key = [[ZTSQLiteStatementKey alloc] initWithOperation:ZTSQLiteStatementOperationSelect tableName:tableName columnIndexes:projection ?: self.allColumnIndexes whereClause:whereClause positional:NO];
+    return [self statementForKey:key];
+}
+
+- (void)dealloc {
+    for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+        free(_columns[idx].columnNameUTF8);
+    }
+    free(_columns);
+
+#if ZTSQLITE_INSTRUMENTATION
+    free(_instrumentationStatistics);
+#endif
+}
+
+- (NSIndexSet *)columnIndexesForPropertyKeys:(NSSet *)propertyKeys {
+    NSMutableIndexSet *columnIndexes = [NSMutableIndexSet indexSet];
+
+    for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+        if ([propertyKeys containsObject:_columns[idx].propertyKey]) {
+            [columnIndexes addIndex:idx];
+        }
+    }
+
+    return columnIndexes;
+}
+
+- (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model columnIndexes:(NSIndexSet *)columnIndexes error:(NSError *__autoreleasing *)error {
+    ZTSQLITE_INSTRUMENT_START(startTime);
+
+    NSMutableDictionary *parameterDictionary = [NSMutableDictionary dictionaryWithCapacity:columnIndexes.count];
+
+    for (NSUInteger idx = columnIndexes.firstIndex; idx != NSNotFound; idx = [columnIndexes indexGreaterThanIndex:idx]) {
+        const ZTSQLiteColumn *column = &_columns[idx];
+
+        id value = ZTSQLiteParameterValueOfModel(column, model, error);
+        if (value == nil) {
+            ZTSQLITE_INSTRUMENT_COUNT(ZTSQLiteInstrumentationEventTransformerFailure);
+            return nil;
+        }
+
+        parameterDictionary[column->columnName] = value;
+    }
+
+    ZTSQLITE_INSTRUMENT_END(ZTSQLiteInstrumentationEventEncodeTransform, startTime);
+
+    return parameterDictionary;
+}
+
+// Serializes the columns of `model` at `columnIndexes` in plan order and
+// appends the values to `parameters`.
+//
+// Returns whether serialization succeeded.
+- (BOOL)appendParameterValuesFromModel:(id<ZTSQLiteSerializing>)model columnIndexes:(NSIndexSet *)columnIndexes toArray:(NSMutableArray *)parameters error:(NSError *__autoreleasing *)error {
+    ZTSQLITE_INSTRUMENT_START(startTime);
+
+    for (NSUInteger idx = columnIndexes.firstIndex; idx != NSNotFound; idx = [columnIndexes indexGreaterThanIndex:idx]) {
+        id value = ZTSQLiteParameterValueOfModel(&_columns[idx], model, error);
+        if (value == nil) {
+            ZTSQLITE_INSTRUMENT_COUNT(ZTSQLiteInstrumentationEventTransformerFailure);
+            return NO;
+        }
+
+        [parameters addObject:value];
+    }
+
+    ZTSQLITE_INSTRUMENT_END(ZTSQLiteInstrumentationEventEncodeTransform, startTime);
+
+    return YES;
+}
+
+// Serializes the columns of `model` at `columnIndexes` that differ from the
+// change snapshot taken when the model was decoded. If the model has no
+// snapshot, all columns are serialized.
+//
+// values - On return, holds the serialized values of the returned columns in
+//          plan order.
+//
+// Returns the plan indexes of the changed columns, or nil if a serialization
+// error occurred.
+- (NSIndexSet *)changedColumnIndexes:(NSIndexSet *)columnIndexes ofModel:(id<ZTSQLiteSerializing>)model values:(NSMutableArray *)values error:(NSError *__autoreleasing *)error {
+    ZTSQLITE_INSTRUMENT_START(startTime);
+
+    NSArray *snapshot = self.tracksChanges ? objc_getAssociatedObject(model, &ZTSQLiteChangeSnapshotKey) : nil;
+    NSMutableIndexSet *changedColumnIndexes = snapshot ? [NSMutableIndexSet indexSet] : nil;
+
+    for (NSUInteger idx = columnIndexes.firstIndex; idx != NSNotFound; idx = [columnIndexes indexGreaterThanIndex:idx]) {
+        id value = ZTSQLiteParameterValueOfModel(&_columns[idx], model, error);
+        if (value == nil) {
+            ZTSQLITE_INSTRUMENT_COUNT(ZTSQLiteInstrumentationEventTransformerFailure);
+            return nil;
+        }
+
+        if (snapshot != nil) {
+            id originalValue = snapshot[idx];
+            if (value == originalValue || [value isEqual:originalValue]) {
+                continue;
+            }
+
+            [changedColumnIndexes addIndex:idx];
+        }
+
+        [values addObject:value];
+    }
+
+    ZTSQLITE_INSTRUMENT_END(ZTSQLiteInstrumentationEventEncodeTransform, startTime);
+
+    return changedColumnIndexes ?: columnIndexes;
+}
+
+// Remembers the raw column values `model` was decoded from, so that later
+// UPDATE statements only write the columns that changed, and the identity map
+// can tell whether a row changed.
+- (void)recordChangeSnapshotOfModel:(id)model columnValues:(id const __unsafe_unretained *)values {
+    __unsafe_unretained id snapshot[MAX(_columnCount, 1)];
+    for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+        snapshot[idx] = values[idx] ?: ZTSQLiteMissingColumnValue();
+    }
+
+    objc_setAssociatedObject(model, &ZTSQLiteChangeSnapshotKey, [NSArray arrayWithObjects:snapshot count:_columnCount], OBJC_ASSOCIATION_RETAIN);
+}
+
+// Returns the identity map key of a row, or nil if a primary key column is
+// missing from the row.
+- (NSArray *)primaryKeyWithColumnValues:(id const __unsafe_unretained *)values {
+    NSIndexSet *primaryKeyColumnIndexes = self.primaryKeyColumnIndexes;
+    __unsafe_unretained id primaryKey[MAX(primaryKeyColumnIndexes.count, 1)];
+    NSUInteger count = 0;
+
+    for (NSUInteger idx = primaryKeyColumnIndexes.firstIndex; idx != NSNotFound; idx = [primaryKeyColumnIndexes indexGreaterThanIndex:idx]) {
+        if (values[idx] == nil) {
+            return nil;
+        }
+
+        primaryKey[count++] = values[idx];
+    }
+
+    return [NSArray arrayWithObjects:primaryKey count:count];
+}
+
+// Returns the resident model decoded from a row with `primaryKey`, if it is
+// still alive and the row hasn't changed since.
+- (id)residentModelWithPrimaryKey:(NSArray *)primaryKey columnValues:(id const __unsafe_unretained *)values {
+    id model = nil;
+    @synchronized(self.residentModelsByPrimaryKey) {
+        model = [self.residentModelsByPrimaryKey objectForKey:primaryKey];
+    }
+
+    NSArray *snapshot = model ? objc_getAssociatedObject(model, &ZTSQLiteChangeSnapshotKey) : nil;
+    if (snapshot == nil) {
+        return nil;
+    }
+
+    for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+        id value = values[idx] ?: ZTSQLiteMissingColumnValue();
+        id originalValue = snapshot[idx];
+
+        if (value != originalValue && ![value isEqual:originalValue]) {
+            return nil;
+        }
+    }
+
+    return model;
+}
+
+- (NSString *)placeholderForColumnAtIndex:(NSUInteger)idx positional:(BOOL)positional {
+    return positional ? @"?" : [@":" stringByAppendingString:_columns[idx].columnName];
+}
+
+- (NSString *)assignmentsWithColumnIndexes:(NSIndexSet *)columnIndexes separator:(NSString *)separator positional:(BOOL)positional {
+    NSMutableArray *components = [NSMutableArray arrayWithCapacity:columnIndexes.count];
+    for (NSUInteger idx = columnIndexes.firstIndex; idx != NSNotFound; idx = [columnIndexes indexGreaterThanIndex:idx]) {
+        [components addObject:[NSString stringWithFormat:@"%@ = %@", _columns[idx].columnName, [self placeholderForColumnAtIndex:idx positional:positional]]];
+    }
+    return [components componentsJoinedByString:separator];
+}
+
+- (NSString *)columnNamesWithColumnIndexes:(NSIndexSet *)columnIndexes {
+    NSMutableArray *columnNames = [NSMutableArray arrayWithCapacity:columnIndexes.count];
+    for (NSUInteger idx = columnIndexes.firstIndex; idx != NSNotFound; idx = [columnIndexes indexGreaterThanIndex:idx]) {
+        [columnNames addObject:_columns[idx].columnName];
+    }
+    return [columnNames componentsJoinedByString:@", "];
+}
+
+- (NSString *)valuesWithColumnIndexes:(NSIndexSet *)columnIndexes rowCount:(NSUInteger)rowCount positional:(BOOL)positional {
+    NSMutableArray *parameters = [NSMutableArray arrayWithCapacity:columnIndexes.count];
+    for (NSUInteger idx = columnIndexes.firstIndex; idx != NSNotFound; idx = [columnIndexes indexGreaterThanIndex:idx]) {
+        [parameters addObject:[self placeholderForColumnAtIndex:idx positional:positional]];
+    }
+
+    NSString *row = [NSString stringWithFormat:@"(%@)", [parameters componentsJoinedByString:@", "]];
+    NSMutableArray *rows = [NSMutableArray arrayWithCapacity:rowCount];
+    for (NSUInteger idx = 0; idx < rowCount; idx++) {
+        [rows addObject:row];
+    }
+    return [rows componentsJoinedByString:@", "];
+}
+
+- (NSString *)generateStatementForKey:(ZTSQLiteStatementKey *)key {
+    NSString *tableName = key.tableName;
+    NSIndexSet *columnIndexes = key.columnIndexes;
+    BOOL positional = key.positional;
+    NSString *statement = nil;
+
+    switch (key.operation) {
+        case ZTSQLiteStatementOperationInsert:
+            // An empty column list is a syntax error. Such rows are inserted one
+            // statement at a time.
+            if (columnIndexes.count == 0) {
+                NSAssert(key.rowCount <= 1, @"Rows without columns can't be inserted by a multi-row statement.");
+                statement = [NSString stringWithFormat:@"INSERT INTO %@ DEFAULT VALUES;", tableName];
+                break;
+            }
+
+            statement = [NSString stringWithFormat:@"INSERT INTO %@ (%@) VALUES %@;", tableName,
+                         [self columnNamesWithColumnIndexes:columnIndexes],
+                         [self valuesWithColumnIndexes:columnIndexes rowCount:key.rowCount positional:positional]];
+            break;
+
+        case ZTSQLiteStatementOperationUpdate:
+            statement = [NSString stringWithFormat:@"UPDATE %@ SET %@ WHERE %@;", tableName,
+                         [self assignmentsWithColumnIndexes:columnIndexes separator:@", " positional:positional],
+                         [self assignmentsWithColumnIndexes:self.primaryKeyColumnIndexes separator:@" AND " positional:positional]];
+            break;
+
+        case ZTSQLiteStatementOperationDelete:
+            if (key.rowCount <= 1) {
+                statement = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@;", tableName,
+                             [self assignmentsWithColumnIndexes:self.primaryKeyColumnIndexes separator:@" AND " positional:positional]];
+            } else if (self.primaryKeyColumnIndexes.count == 1) {
+                NSString *placeholder = [self placeholderForColumnAtIndex:self.primaryKeyColumnIndexes.firstIndex positional:positional];
+                NSMutableArray *placeholders = [NSMutableArray arrayWithCapacity:key.rowCount];
+                for (NSUInteger idx = 0; idx < key.rowCount; idx++) {
+                    [placeholders addObject:placeholder];
+                }
+
+                statement = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@ IN (%@);", tableName,
+                             [self columnNamesWithColumnIndexes:self.primaryKeyColumnIndexes], [placeholders componentsJoinedByString:@", "]];
+            } else if (sqlite3_libversion_number() >= 3015000) {
+                // Row values need SQLite 3.15 or later.
+                statement = [NSString stringWithFormat:@"DELETE FROM %@ WHERE (%@) IN (VALUES %@);", tableName,
+                             [self columnNamesWithColumnIndexes:self.primaryKeyColumnIndexes],
+                             [self valuesWithColumnIndexes:self.primaryKeyColumnIndexes rowCount:key.rowCount positional:positional]];
+            } else {
+                // Binds the same parameters in the same order as row values.
+                NSString *condition = [NSString stringWithFormat:@"(%@)", [self assignmentsWithColumnIndexes:self.primaryKeyColumnIndexes separator:@" AND " positional:positional]];
+                NSMutableArray *conditions = [NSMutableArray arrayWithCapacity:key.rowCount];
+                for (NSUInteger idx = 0; idx < key.rowCount; idx++) {
+                    [conditions addObject:condition];
+                }
+
+                statement = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@;", tableName, [conditions componentsJoinedByString:@" OR "]];
+            }
+            break;
+
+        case ZTSQLiteStatementOperationUpsert: {
+            // The excluded table holds the row that failed to insert, so the
+            // update needs no parameters of its own.
+            NSIndexSet *conflictUpdateColumnIndexes = key.conflictUpdateColumnIndexes;
+            NSMutableArray *assignments = [NSMutableArray arrayWithCapacity:conflictUpdateColumnIndexes.count];
+            for (NSUInteger idx = conflictUpdateColumnIndexes.firstIndex; idx != NSNotFound; idx = [conflictUpdateColumnIndexes indexGreaterThanIndex:idx]) {
+                NSString *name = _columns[idx].columnName;
+                [assignments addObject:[NSString stringWithFormat:@"%@ = excluded.%@", name, name]];
+            }
+
+            NSString *action = assignments.count ? [@"DO UPDATE SET " stringByAppendingString:[assignments componentsJoinedByString:@", "]] : @"DO NOTHING";
+
+            statement = [NSString stringWithFormat:@"INSERT INTO %@ (%@) VALUES %@ ON CONFLICT (%@) %@;", tableName,
+                         [self columnNamesWithColumnIndexes:columnIndexes],
+                         [self valuesWithColumnIndexes:columnIndexes rowCount:key.rowCount positional:positional],
+                         [self columnNamesWithColumnIndexes:self.primaryKeyColumnIndexes], action];
+            break;
+        }
+
+        case ZTSQLiteStatementOperationSelect:
+            if (key.whereClause.length) {
+                statement = [NSString stringWithFormat:@"SELECT %@ FROM %@ WHERE %@;", [self columnNamesWithColumnIndexes:columnIndexes], tableName, key.whereClause];
+            } else {
+                statement = [NSString stringWithFormat:@"SELECT %@ FROM %@;", [self columnNamesWithColumnIndexes:columnIndexes], tableName];
+            }
+            break;
+
+        case ZTSQLiteStatementOperationSelectByPrimaryKey:
+            statement = [NSString stringWithFormat:@"SELECT %@ FROM %@ WHERE %@;", [self columnNamesWithColumnIndexes:columnIndexes], tableName,
+                         [self assignmentsWithColumnIndexes:self.primaryKeyColumnIndexes separator:@" AND " positional:positional]];
+            break;
+    }
+
+    return statement;
+}
+
+- (NSString *)statementForOperation:(ZTSQLiteStatementOperation)operation tableName:(NSString *)tableName columnIndexes:(NSIndexSet *)columnIndexes {
+    return [self statementForOperation:operation tableName:tableName columnIndexes:columnIndexes rowCount:1 positional:NO];
+}
+
+// Returns a cached statement, generating it if necessary.
+//
+// operation     - The kind of statement.
+// tableName     - The name of the table the statement will be executed on.
+// columnIndexes - The column plan indexes of the columns to insert or update.
+//                 Ignored for DELETE statements.
+// rowCount      - The number of rows written by a multi-row INSERT statement.
+// positional    - Whether to use `?` placeholders. Values are then bound in
+//                 plan order, SET columns before primary key columns.
+//
+// Returns a statement with the columns in plan order. Equal statements are
+// always returned as the same string instance.
+- (NSString *)statementForOperation:(ZTSQLiteStatementOperation)operation tableName:(NSString *)tableName columnIndexes:(NSIndexSet *)columnIndexes rowCount:(NSUInteger)rowCount positional:(BOOL)positional {
+    return [self statementForKey:[[ZTSQLiteStatementKey alloc] initWithOperation:operation tableName:tableName columnIndexes:columnIndexes rowCount:rowCount positional:positional]];
+}
+
+- (NSString *)statementForKey:(ZTSQLiteStatementKey *)key {
+    // WHERE clauses are supplied by callers and may embed values, so caching
+    // their statements could grow the cache without bound.
+    BOOL cacheable = key.whereClause.length == 0;
+
+    NSString *statement = nil;
+    if (cacheable) {
+        @synchronized(self.statementsByKey) {
+            statement = self.statementsByKey[key];
+        }
+    }
+
+    if (statement != nil) {
+        return statement;
+    }
+
+    ZTSQLITE_INSTRUMENT_START(startTime);
+    statement = [self generateStatementForKey:key];
+    ZTSQLITE_INSTRUMENT_END(ZTSQLiteInstrumentationEventStatementBuilding, startTime);
+
+    if (!cacheable) {
+        return statement;
+    }
+
+    @synchronized(self.statementsByKey) {
+        NSString *existingStatement = self.statementsByKey[key];
+        if (existingStatement != nil) {
+            return existingStatement;
+        }
+
+        self.statementsByKey[key] = statement;
+    }
+
+    return statement;
+}
+
+// Returns the statement upserting the columns at `columnIndexes` into
+// `tableName`. On conflict, the columns that are also updatable for `model`
+// are overwritten.
+- (NSString *)upsertStatementForModel:(id<ZTSQLiteSerializing>)model tableName:(NSString *)tableName columnIndexes:(NSIndexSet *)columnIndexes positional:(BOOL)positional {
+    NSIndexSet *conflictUpdateColumnIndexes = [self conflictUpdateColumnIndexesForModel:model insertedColumnIndexes:columnIndexes];
+
+    ZTSQLiteStatementKey *key = [[ZTSQLiteStatementKey alloc] initWithOperation:ZTSQLiteStatementOperationUpsert tableName:tableName columnIndexes:columnIndexes conflictUpdateColumnIndexes:conflictUpdateColumnIndexes rowCount:1 positional:positional];
+    return [self statementForKey:key];
+}
+
+// Returns the plan indexes of the columns an upsert of `model` inserting the
+// columns at `columnIndexes` overwrites on conflict.
+- (NSIndexSet *)conflictUpdateColumnIndexesForModel:(id<ZTSQLiteSerializing>)model insertedColumnIndexes:(NSIndexSet *)columnIndexes {
+    NSMutableIndexSet *conflictUpdateColumnIndexes = [[self columnIndexesToUpdateForModel:model] mutableCopy];
+    [conflictUpdateColumnIndexes removeIndexes:self.primaryKeyColumnIndexes];
+
+    // Columns that are not inserted would be reset to their defaults.
+    NSMutableIndexSet *notInsertedColumnIndexes = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, _columnCount)];
+    [notInsertedColumnIndexes removeIndexes:columnIndexes];
+    [conflictUpdateColumnIndexes removeIndexes:notInsertedColumnIndexes];
+
+    return conflictUpdateColumnIndexes;
+}
+
+- (NSIndexSet *)columnIndexesToInsertForModel:(id<ZTSQLiteSerializing>)model {
+    return [self columnIndexesForPropertyKeys:[self insertablePropertyKeys:self.mappedPropertyKeys forModel:model]];
+}
+
+- (NSIndexSet *)columnIndexesToUpdateForModel:(id<ZTSQLiteSerializing>)model {
+    NSIndexSet *columnIndexes = [self columnIndexesForPropertyKeys:[self updatablePropertyKeys:self.mappedPropertyKeys forModel:model]];
+
+    // Properties that were not decoded don't hold the values of their columns.
+    NSIndexSet *projection = objc_getAssociatedObject(model, &ZTSQLiteProjectionKey);
+    if (projection != nil) {
+        columnIndexes = [columnIndexes indexesPassingTest:^BOOL(NSUInteger idx, BOOL *stop) {
+            return [projection containsIndex:idx];
+        }];
+    }
+
+    return columnIndexes;
+}
+
+// Returns whether the primary key columns of `model` can identify its row,
+// which is not the case if it was decoded without them.
+- (BOOL)validatePrimaryKeyOfModel:(id<ZTSQLiteSerializing>)model error:(NSError *__autoreleasing *)error {
+    NSIndexSet *projection = objc_getAssociatedObject(model, &ZTSQLiteProjectionKey);
+    if (projection == nil || [projection containsIndexes:self.primaryKeyColumnIndexes]) {
+        return YES;
+    }
+
+    if (error) {
+        NSDictionary *userInfo = @{ NSLocalizedDescriptionKey: NSLocalizedString(@"Could not serialize model", @""),
+                                    NSLocalizedFailureReasonErrorKey: [NSString stringWithFormat:NSLocalizedString(@"%@ was decoded without its primary key.", @""), model]
+                                    };
+
+        *error = [NSError errorWithDomain:ZTSQLiteAdapterErrorDomain code:ZTSQLiteAdapterErrorPrimaryKeyNotDecoded userInfo:userInfo];
+    }
+
+    return NO;
+}
+
+- (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model insertingIntoTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(model);
+    NSParameterAssert([model isKindOfClass:self.modelClass]);
+    NSParameterAssert(tableName);
+
+    if (self.modelClass != model.class) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
+        return [otherAdapter parameterDictionaryFromModel:model insertingIntoTable:tableName statement:statement error:error];
+    }
+
+    NSIndexSet *columnIndexesToInsert = [self columnIndexesToInsertForModel:model];
+
+    if (statement) {
+        *statement = [self statementForOperation:ZTSQLiteStatementOperationInsert tableName:tableName columnIndexes:columnIndexesToInsert];
+    }
+
+    return [self parameterDictionaryFromModel:model columnIndexes:columnIndexesToInsert error:error];
+}
+
+- (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model updatingInTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(model);
+    NSParameterAssert([model isKindOfClass:self.modelClass]);
+    NSParameterAssert(tableName);
+
+    if (self.modelClass != model.class) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
+        return [otherAdapter parameterDictionaryFromModel:model updatingInTable:tableName statement:statement error:error];
+    }
+
+    if (![self validatePrimaryKeyOfModel:model error:error]) {
+        return nil;
+    }
+
+    NSMutableArray *values = [NSMutableArray array];
+    NSIndexSet *columnIndexesToUpdate = [self changedColumnIndexes:[self columnIndexesToUpdateForModel:model] ofModel:model values:values error:error];
+    if (columnIndexesToUpdate == nil) {
+        return nil;
+    }
+
+    NSMutableDictionary *parameterDictionary = [NSMutableDictionary dictionaryWithCapacity:values.count + self.primaryKeyColumnIndexes.count];
+    NSUInteger valueIdx = 0;
+    for (NSUInteger idx = columnIndexesToUpdate.firstIndex; idx != NSNotFound; idx = [columnIndexesToUpdate indexGreaterThanIndex:idx]) {
+        parameterDictionary[_columns[idx].columnName] = values[valueIdx++];
+    }
+
+    if (columnIndexesToUpdate.count == 0) {
+        if (statement) {
+            *statement = nil;
+        }
+        return parameterDictionary;
+    }
+
+    if (self.primaryKeyColumnIndexes) {
+        NSDictionary *primaryKeyParameters = [self parameterDictionaryFromModel:model columnIndexes:self.primaryKeyColumnIndexes error:error];
+        if (primaryKeyParameters == nil) {
+            return nil;
+        }
+
+        [parameterDictionary addEntriesFromDictionary:primaryKeyParameters];
+
+        if (self.primaryKeyColumnIndexes.count) {
+            if (statement) {
+                *statement = [self statementForOperation:ZTSQLiteStatementOperationUpdate tableName:tableName columnIndexes:columnIndexesToUpdate];
+            }
+        }
+    }
+
+    return parameterDictionary;
+}
+
+- (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model deletingFromTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(model);
+    NSParameterAssert([model isKindOfClass:self.modelClass]);
+    NSParameterAssert(tableName);
+
+    if (self.modelClass != model.class) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
+        return [otherAdapter parameterDictionaryFromModel:model deletingFromTable:tableName statement:statement error:error];
+    }
+
+    if (![self validatePrimaryKeyOfModel:model error:error]) {
+        return nil;
+    }
+
+    if (self.primaryKeyColumnIndexes.count) {
+        if (statement) {
+            *statement = [self statementForOperation:ZTSQLiteStatementOperationDelete tableName:tableName columnIndexes:self.primaryKeyColumnIndexes];
+        }
+
+        return [self parameterDictionaryFromModel:model columnIndexes:self.primaryKeyColumnIndexes error:error];
+    }
+
+    return nil;
+}
+
+- (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model upsertingIntoTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(model);
+    NSParameterAssert([model isKindOfClass:self.modelClass]);
+    NSParameterAssert(tableName);
+
+    if (self.modelClass != model.class) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
+        return [otherAdapter parameterDictionaryFromModel:model upsertingIntoTable:tableName statement:statement error:error];
+    }
+
+    if (![self validatePrimaryKeyOfModel:model error:error]) {
+        return nil;
+    }
+
+    if (!self.primaryKeyColumnIndexes.count) {
+        return nil;
+    }
+
+    NSMutableIndexSet *columnIndexesToInsert = [[self columnIndexesToInsertForModel:model] mutableCopy];
+    [columnIndexesToInsert addIndexes:self.primaryKeyColumnIndexes];
+
+    if (statement) {
+        *statement = [self upsertStatementForModel:model tableName:tableName columnIndexes:columnIndexesToInsert positional:NO];
+    }
+
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:columnIndexesToInsert.count];
+    if (![self appendParameterValuesFromModel:model columnIndexes:columnIndexesToInsert toArray:values error:error]) {
+        return nil;
+    }
+
+    NSMutableDictionary *parameterDictionary = [NSMutableDictionary dictionaryWithCapacity:values.count];
+    NSUInteger valueIdx = 0;
+    for (NSUInteger idx = columnIndexesToInsert.firstIndex; idx != NSNotFound; idx = [columnIndexesToInsert indexGreaterThanIndex:idx]) {
+        parameterDictionary[_columns[idx].columnName] = values[valueIdx++];
+    }
+
+    return parameterDictionary;
+}
+
+- (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model selectingFromTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(model);
+    NSParameterAssert([model isKindOfClass:self.modelClass]);
+    NSParameterAssert(tableName);
+
+    if (self.modelClass != model.class) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
+        return [otherAdapter parameterDictionaryFromModel:model selectingFromTable:tableName statement:statement error:error];
+    }
+
+    if (!self.primaryKeyColumnIndexes.count) {
+        return nil;
+    }
+
+    if (statement) {
+        *statement = [self statementForOperation:ZTSQLiteStatementOperationSelectByPrimaryKey tableName:tableName columnIndexes:self.allColumnIndexes rowCount:1 positional:NO];
+    }
+
+    return [self parameterDictionaryFromModel:model columnIndexes:self.primaryKeyColumnIndexes error:error];
+}
+
+- (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model insertingIntoTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(model);
+    NSParameterAssert([model isKindOfClass:self.modelClass]);
+    NSParameterAssert(tableName);
+
+    if (self.modelClass != model.class) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
+        return [otherAdapter parameterArrayFromModel:model insertingIntoTable:tableName statement:statement error:error];
+    }
+
+    NSIndexSet *columnIndexesToInsert = [self columnIndexesToInsertForModel:model];
+
+    if (statement) {
+        *statement = [self statementForOperation:ZTSQLiteStatementOperationInsert tableName:tableName columnIndexes:columnIndexesToInsert rowCount:1 positional:YES];
+    }
+
+    NSMutableArray *parameters = [NSMutableArray arrayWithCapacity:columnIndexesToInsert.count];
+    if (![self appendParameterValuesFromModel:model columnIndexes:columnIndexesToInsert toArray:parameters error:error]) {
+        return nil;
+    }
+
+    return parameters;
+}
+
+- (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model updatingInTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(model);
+    NSParameterAssert([model isKindOfClass:self.modelClass]);
+    NSParameterAssert(tableName);
+
+    if (self.modelClass != model.class) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
+        return [otherAdapter parameterArrayFromModel:model updatingInTable:tableName statement:statement error:error];
+    }
+
+    if (![self validatePrimaryKeyOfModel:model error:error]) {
+        return nil;
+    }
+
+    if (!self.primaryKeyColumnIndexes.count) {
+        return nil;
+    }
+
+    NSMutableArray *parameters = [NSMutableArray array];
+    NSIndexSet *columnIndexesToUpdate = [self changedColumnIndexes:[self columnIndexesToUpdateForModel:model] ofModel:model values:parameters error:error];
+    if (columnIndexesToUpdate == nil) {
+        return nil;
+    }
+
+    if (columnIndexesToUpdate.count == 0) {
+        if (statement) {
+            *statement = nil;
+        }
+        return parameters;
+    }
+
+    if (statement) {
+        *statement = [self statementForOperation:ZTSQLiteStatementOperationUpdate tableName:tableName columnIndexes:columnIndexesToUpdate rowCount:1 positional:YES];
+    }
+
+    if (![self appendParameterValuesFromModel:model columnIndexes:self.primaryKeyColumnIndexes toArray:parameters error:error]) {
+        return nil;
+    }
+
+    return parameters;
+}
+
+- (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model deletingFromTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(model);
+    NSParameterAssert([model isKindOfClass:self.modelClass]);
+    NSParameterAssert(tableName);
+
+    if (self.modelClass != model.class) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
+        return [otherAdapter parameterArrayFromModel:model deletingFromTable:tableName statement:statement error:error];
+    }
+
+    if (![self validatePrimaryKeyOfModel:model error:error]) {
+        return nil;
+    }
+
+    if (!self.primaryKeyColumnIndexes.count) {
+        return nil;
+    }
+
+    if (statement) {
+        *statement = [self statementForOperation:ZTSQLiteStatementOperationDelete tableName:tableName columnIndexes:self.primaryKeyColumnIndexes rowCount:1 positional:YES];
+    }
+
+    NSMutableArray *parameters = [NSMutableArray arrayWithCapacity:self.primaryKeyColumnIndexes.count];
+    if (![self appendParameterValuesFromModel:model columnIndexes:self.primaryKeyColumnIndexes toArray:parameters error:error]) {
+        return nil;
+    }
+
+    return parameters;
+}
+
+- (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model selectingFromTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(model);
+    NSParameterAssert([model isKindOfClass:self.modelClass]);
+    NSParameterAssert(tableName);
+
+    if (self.modelClass != model.class) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
+        return [otherAdapter parameterArrayFromModel:model selectingFromTable:tableName statement:statement error:error];
+    }
+
+    if (!self.primaryKeyColumnIndexes.count) {
+        return nil;
+    }
+
+    if (statement) {
+        *statement = [self statementForOperation:ZTSQLiteStatementOperationSelectByPrimaryKey tableName:tableName columnIndexes:self.allColumnIndexes rowCount:1 positional:YES];
+    }
+
+    NSMutableArray *parameters = [NSMutableArray arrayWithCapacity:self.primaryKeyColumnIndexes.count];
+    if (![self appendParameterValuesFromModel:model columnIndexes:self.primaryKeyColumnIndexes toArray:parameters error:error]) {
+        return nil;
+    }
+
+    return parameters;
+}
+
+- (NSArray *)parameterArrayFromModel:(id<ZTSQLiteSerializing>)model upsertingIntoTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(model);
+    NSParameterAssert([model isKindOfClass:self.modelClass]);
+    NSParameterAssert(tableName);
+
+    if (self.modelClass != model.class) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
+        return [otherAdapter parameterArrayFromModel:model upsertingIntoTable:tableName statement:statement error:error];
+    }
+
+    if (![self validatePrimaryKeyOfModel:model error:error]) {
+        return nil;
+    }
+
+    if (!self.primaryKeyColumnIndexes.count) {
+        return nil;
+    }
+
+    NSMutableIndexSet *columnIndexesToInsert = [[self columnIndexesToInsertForModel:model] mutableCopy];
+    [columnIndexesToInsert addIndexes:self.primaryKeyColumnIndexes];
+
+    if (statement) {
+        *statement = [self upsertStatementForModel:model tableName:tableName columnIndexes:columnIndexesToInsert positional:YES];
+    }
+
+    NSMutableArray *parameters = [NSMutableArray arrayWithCapacity:columnIndexesToInsert.count];
+    if (![self appendParameterValuesFromModel:model columnIndexes:columnIndexesToInsert toArray:parameters error:error]) {
+        return nil;
+    }
+
+    return parameters;
+}
+
+- (NSArray *)parameterArraysFromModels:(NSArray *)models insertingIntoTable:(NSString *)tableName statements:(NSArray *__autoreleasing *)statements error:(NSError *__autoreleasing *)error {
+    return [self parameterArraysFromModels:models writingToTable:tableName upserting:NO statements:statements error:error];
+}
+
+- (NSArray *)parameterArraysFromModels:(NSArray *)models upsertingIntoTable:(NSString *)tableName statements:(NSArray *__autoreleasing *)statements error:(NSError *__autoreleasing *)error {
+    return [self parameterArraysFromModels:models writingToTable:tableName upserting:YES statements:statements error:error];
+}
+
+// Serializes models into chunked multi-row INSERT statements, or into upserts
+// if `upserting` is YES. Consecutive models share a statement as long as they
+// insert, and on conflict overwrite, the same columns.
+- (NSArray *)parameterArraysFromModels:(NSArray *)models writingToTable:(NSString *)tableName upserting:(BOOL)upserting statements:(NSArray *__autoreleasing *)statements error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(models);
+    NSParameterAssert(tableName);
+
+    ZTSQLiteStatementOperation operation = upserting ? ZTSQLiteStatementOperationUpsert : ZTSQLiteStatementOperationInsert;
+
+    NSMutableArray *parameterArrays = [NSMutableArray array];
+    NSMutableArray *chunkStatements = [NSMutableArray array];
+
+    ZTSQLiteAdapter *chunkAdapter = nil;
+    NSIndexSet *chunkColumnIndexes = nil;
+    NSIndexSet *chunkConflictUpdateColumnIndexes = nil;
+    NSMutableArray *chunkParameters = nil;
+    NSUInteger chunkRowCount = 0;
+
+    for (id<ZTSQLiteSerializing> model in models) {
+        NSAssert([model isKindOfClass:self.modelClass], @"%@ is not an instance of %@.", model, self.modelClass);
+
+        ZTSQLiteAdapter *adapter = self;
+        if (self.modelClass != model.class) {
+            adapter = [self SQLiteAdapterForModelClass:model.class error:error];
+            if (adapter == nil) {
+                return nil;
+            }
+        }
+
+        NSIndexSet *columnIndexes = [adapter columnIndexesToInsertForModel:model];
+        NSIndexSet *conflictUpdateColumnIndexes = nil;
+
+        if (upserting) {
+            if (![adapter validatePrimaryKeyOfModel:model error:error]) {
+                return nil;
+            }
+
+            if (!adapter.primaryKeyColumnIndexes.count) {
+                return nil;
+            }
+
+            NSMutableIndexSet *upsertedColumnIndexes = [columnIndexes mutableCopy];
+            [upsertedColumnIndexes addIndexes:adapter.primaryKeyColumnIndexes];
+            columnIndexes = upsertedColumnIndexes;
+            conflictUpdateColumnIndexes = [adapter conflictUpdateColumnIndexesForModel:model insertedColumnIndexes:columnIndexes];
+        }
+
+        NSUInteger variablesPerRow = MAX(columnIndexes.count, 1);
+
+        // Models inserting no columns get a DEFAULT VALUES statement each.
+        BOOL fitsChunk = chunkRowCount > 0
+            && columnIndexes.count > 0
+            && adapter == chunkAdapter
+            && [columnIndexes isEqualToIndexSet:chunkColumnIndexes]
+            && (conflictUpdateColumnIndexes == chunkConflictUpdateColumnIndexes || [conflictUpdateColumnIndexes isEqualToIndexSet:chunkConflictUpdateColumnIndexes])
+            && chunkRowCount < ZTSQLiteAdapterMaximumRowsPerStatement
+            && (chunkRowCount + 1) * variablesPerRow <= ZTSQLiteAdapterMaximumVariableNumber;
+
+        if (!fitsChunk) {
+            if (chunkRowCount > 0) {
+                [chunkStatements addObject:[chunkAdapter statementForKey:[[ZTSQLiteStatementKey alloc] initWithOperation:operation tableName:tableName columnIndexes:chunkColumnIndexes conflictUpdateColumnIndexes:chunkConflictUpdateColumnIndexes rowCount:chunkRowCount positional:YES]]];
+                [parameterArrays addObject:chunkParameters];
+            }
+
+            chunkAdapter = adapter;
+            chunkColumnIndexes = columnIndexes;
+            chunkConflictUpdateColumnIndexes = conflictUpdateColumnIndexes;
+            chunkParameters = [NSMutableArray arrayWithCapacity:MIN(models.count, ZTSQLiteAdapterMaximumVariableNumber / variablesPerRow) * columnIndexes.count];
+            chunkRowCount = 0;
+        }
+
+        if (![adapter appendParameterValuesFromModel:model columnIndexes:columnIndexes toArray:chunkParameters error:error]) {
+            return nil;
+        }
+
+        chunkRowCount++;
+    }
+
+    if (chunkRowCount > 0) {
+        [chunkStatements addObject:[chunkAdapter statementForKey:[[ZTSQLiteStatementKey alloc] initWithOperation:operation tableName:tableName columnIndexes:chunkColumnIndexes conflictUpdateColumnIndexes:chunkConflictUpdateColumnIndexes rowCount:chunkRowCount positional:YES]]];
+        [parameterArrays addObject:chunkParameters];
+    }
+
+    if (statements) {
+        *statements = chunkStatements;
+    }
+
+    return parameterArrays;
+}
+
+- (NSArray *)parameterArraysFromModels:(NSArray *)models deletingFromTable:(NSString *)tableName statements:(NSArray *__autoreleasing *)statements error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(models);
+    NSParameterAssert(tableName);
+
+    NSMutableArray *parameterArrays = [NSMutableArray array];
+    NSMutableArray *chunkStatements = [NSMutableArray array];
+
+    ZTSQLiteAdapter *chunkAdapter = nil;
+    NSMutableArray *chunkParameters = nil;
+    NSUInteger chunkRowCount = 0;
+
+    for (id<ZTSQLiteSerializing> model in models) {
+        NSAssert([model isKindOfClass:self.modelClass], @"%@ is not an instance of %@.", model, self.modelClass);
+
+        ZTSQLiteAdapter *adapter = self;
+        if (self.modelClass != model.class) {
+            adapter = [self SQLiteAdapterForModelClass:model.class error:error];
+            if (adapter == nil) {
+                return nil;
+            }
+        }
+
+        NSUInteger variablesPerRow = adapter.primaryKeyColumnIndexes.count;
+        if (variablesPerRow == 0) {
+            return nil;
+        }
+
+        if (![adapter validatePrimaryKeyOfModel:model error:error]) {
+            return nil;
+        }
+
+        // Subclasses usually share the primary key of their superclass, so
+        // they can be deleted by the same statement.
+        BOOL fitsChunk = chunkRowCount > 0
+            && (adapter == chunkAdapter || [adapter.primaryKeyColumnNames isEqualToArray:chunkAdapter.primaryKeyColumnNames])
+            && (variablesPerRow == 1 || chunkRowCount < ZTSQLiteAdapterMaximumRowsPerStatement)
+            && (chunkRowCount + 1) * variablesPerRow <= ZTSQLiteAdapterMaximumVariableNumber;
+
+        if (!fitsChunk) {
+            if (chunkRowCount > 0) {
+                [chunkStatements addObject:[chunkAdapter statementForOperation:ZTSQLiteStatementOperationDelete tableName:tableName columnIndexes:chunkAdapter.primaryKeyColumnIndexes rowCount:chunkRowCount positional:YES]];
+                [parameterArrays addObject:chunkParameters];
+            }
+
+            chunkAdapter = adapter;
+            chunkParameters = [NSMutableArray arrayWithCapacity:MIN(models.count * variablesPerRow, ZTSQLiteAdapterMaximumVariableNumber)];
+            chunkRowCount = 0;
+        }
+
+        if (![adapter appendParameterValuesFromModel:model columnIndexes:adapter.primaryKeyColumnIndexes toArray:chunkParameters error:error]) {
+            return nil;
+        }
+
+        chunkRowCount++;
+    }
+
+    if (chunkRowCount > 0) {
+        [chunkStatements addObject:[chunkAdapter statementForOperation:ZTSQLiteStatementOperationDelete tableName:tableName columnIndexes:chunkAdapter.primaryKeyColumnIndexes rowCount:chunkRowCount positional:YES]];
+        [parameterArrays addObject:chunkParameters];
+    }
+
+    if (statements) {
+        *statements = chunkStatements;
+    }
+
+    return parameterArrays;
+}
+
+- (BOOL)bindParametersOfStatement:(sqlite3_stmt *)statement fromModel:(id<ZTSQLiteSerializing>)model error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(statement != NULL);
+    NSParameterAssert(model);
+    NSParameterAssert([model isKindOfClass:self.modelClass]);
+
+    if (self.modelClass != model.class) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
+        return [otherAdapter bindParametersOfStatement:statement fromModel:model error:error];
+    }
+
+    ZTSQLITE_INSTRUMENT_START(startTime);
+
+    int count = sqlite3_bind_parameter_count(statement);
+    for (int parameterIdx = 1; parameterIdx <= count; parameterIdx++) {
+        // Skip the `:`, `@` or `$` prefix. Positional parameters have no name.
+        const char *name = sqlite3_bind_parameter_name(statement, parameterIdx);
+        if (name == NULL || name[0] == '\0') continue;
+        name++;
+
+        // Later columns win, like they do in a parameter dictionary.
+        const ZTSQLiteColumn *column = NULL;
+        for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+            if (strcmp(name, _columns[idx].columnNameUTF8) == 0) {
+                column = &_columns[idx];
+            }
+        }
+
+        if (column == NULL) continue;
+
+        int resultCode = SQLITE_OK;
+
+        if (column->scalarType != 0) {
+            ZTSQLiteScalarValue value = ZTSQLiteScalarColumnValueOfModel(column, model);
+            if (value.type == SQLITE_FLOAT) {
+                resultCode = sqlite3_bind_double(statement, parameterIdx, value.realValue);
+            } else {
+                resultCode = sqlite3_bind_int64(statement, parameterIdx, value.integerValue);
+            }
+        } else {
+            id value = ZTSQLiteParameterValueOfModel(column, model, error);
+            if (value == nil) {
+                ZTSQLITE_INSTRUMENT_COUNT(ZTSQLiteInstrumentationEventTransformerFailure);
+                return NO;
+            }
+
+            resultCode = ZTSQLiteBindParameterValue(statement, parameterIdx, value);
+        }
+
+        if (resultCode != SQLITE_OK) {
+            if (error) {
+                *error = ZTSQLiteAdapterStatementFailedError(sqlite3_db_handle(statement), resultCode);
+            }
+            return NO;
+        }
+    }
+
+    ZTSQLITE_INSTRUMENT_END(ZTSQLiteInstrumentationEventEncodeTransform, startTime);
+
+    return YES;
+}
+
+- (BOOL)didPersistModel:(id<ZTSQLiteSerializing>)model error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(model);
+    NSParameterAssert([model isKindOfClass:self.modelClass]);
+
+    if (self.modelClass != model.class) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
+        return [otherAdapter didPersistModel:model error:error];
+    }
+
+    NSArray *snapshot = objc_getAssociatedObject(model, &ZTSQLiteChangeSnapshotKey);
+    if (snapshot == nil) {
+        return YES;
+    }
+
+    // Only the columns an UPDATE or upsert can write may differ from the row.
+    NSIndexSet *columnIndexes = [self columnIndexesToUpdateForModel:model];
+    NSMutableArray *persistedSnapshot = [snapshot mutableCopy];
+    for (NSUInteger idx = columnIndexes.firstIndex; idx != NSNotFound; idx = [columnIndexes indexGreaterThanIndex:idx]) {
+        id value = ZTSQLiteParameterValueOfModel(&_columns[idx], model, error);
+        if (value == nil) {
+            return NO;
+        }
+
+        persistedSnapshot[idx] = value;
+    }
+
+    objc_setAssociatedObject(model, &ZTSQLiteChangeSnapshotKey, [persistedSnapshot copy], OBJC_ASSOCIATION_RETAIN);
+
+    return YES;
+}
+
+// Returns the class that should parse `resultDictionary`, consulting
+// +classForParsingResultDictionary: if the model class implements it.
+//
+// Returns the model class of the receiver, a subclass of it, or nil if no
+// class could be found. In that case `error` is set.
+- (Class)classForParsingResultDictionary:(NSDictionary *)resultDictionary error:(NSError *__autoreleasing *)error {
+    if (!self.parsesClassFromResultDictionary) {
+        return self.modelClass;
+    }
+
+    Class class = [self.modelClass classForParsingResultDictionary:resultDictionary];
+    if (!class) {
+        if (error) {
+            NSDictionary *userInfo = @{ NSLocalizedDescriptionKey: NSLocalizedString(@"Cloud not parse SQLite result dictionary", @""),
+                                        NSLocalizedFailureReasonErrorKey: NSLocalizedString(@"No model class could be found to parse the SQLite result dictionary.", @"")
+                                        };
+
+            *error = [NSError errorWithDomain:ZTSQLiteAdapterErrorDomain code:ZTSQLiteAdapterErrorNoClassFound userInfo:userInfo];
+        }
+
+        return nil;
+    }
+
+    NSAssert(class == self.modelClass || [class conformsToProtocol:@protocol(ZTSQLiteSerializing)], @"Class %@ returned from +classForParsingResultDictionary: does not conform to <ZTSQLiteSerializing>", class);
+
+    return class;
+}
+
+- (id)modelFromResultDictionary:(NSDictionary *)resultDictionary error:(NSError *__autoreleasing *)error {
+    return [self modelFromResultDictionary:resultDictionary propertyKeys:nil error:error];
+}
+
+- (id)modelFromResultDictionary:(NSDictionary *)resultDictionary propertyKeys:(NSSet *)propertyKeys error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(resultDictionary);
+    NSParameterAssert([resultDictionary isKindOfClass:NSDictionary.class]);
+    if (!resultDictionary) {
+        return nil;
+    }
+
+    Class class = [self classForParsingResultDictionary:resultDictionary error:error];
+    if (!class) {
+        return nil;
+    }
+
+    if (class != self.modelClass) {
+        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:class error:error];
+        return [otherAdapter modelFromResultDictionary:resultDictionary propertyKeys:propertyKeys error:error];
+    }
+
+    return [self modelOfOwnClassFromResultDictionary:resultDictionary propertyKeys:propertyKeys error:error];
+}
+
+// Deserializes a model of exactly the receiver's model class from a result
+// dictionary, without consulting +classForParsingResultDictionary:.
+- (id)modelOfOwnClassFromResultDictionary:(NSDictionary *)resultDictionary propertyKeys:(NSSet *)propertyKeys error:(NSError *__autoreleasing *)error {
+    NSIndexSet *projection = [self projectionForPropertyKeys:propertyKeys];
+
+    __unsafe_unretained id values[MAX(_columnCount, 1)];
+    for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+        values[idx] = projection ? nil : [resultDictionary objectForKey:_columns[idx].columnName];
+    }
+
+    for (NSUInteger idx = projection.firstIndex; projection != nil && idx != NSNotFound; idx = [projection indexGreaterThanIndex:idx]) {
+        values[idx] = [resultDictionary objectForKey:_columns[idx].columnName];
+    }
+
+    return [self modelFromColumnValues:values scalarValues:NULL projection:projection resultDictionary:resultDictionary error:error];
+}
+
+// Deserializes one row of a batch from a result dictionary.
+//
+// adaptersByClass - A cache of the adapters used for subclasses returned by
+//                   +classForParsingResultDictionary: during this batch.
+- (id)batchModelFromResultDictionary:(NSDictionary *)resultDictionary propertyKeys:(NSSet *)propertyKeys adaptersByClass:(NSMapTable *)adaptersByClass error:(NSError *__autoreleasing *)error {
+    Class class = [self classForParsingResultDictionary:resultDictionary error:error];
+    if (!class) {
+        return nil;
+    }
+
+    ZTSQLiteAdapter *adapter = self;
+    if (class != self.modelClass) {
+        adapter = [adaptersByClass objectForKey:class];
+
+        if (adapter == nil) {
+            adapter = [self SQLiteAdapterForModelClass:class error:error];
+            if (adapter == nil) {
+                return nil;
+            }
+
+            [adaptersByClass setObject:adapter forKey:class];
+        } else {
+            // -SQLiteAdapterForModelClass:error: counts the redirect otherwise.
+            ZTSQLITE_INSTRUMENT_COUNT(ZTSQLiteInstrumentationEventClassClusterRedirect);
+        }
+    }
+
+    return [adapter modelOfOwnClassFromResultDictionary:resultDictionary propertyKeys:propertyKeys error:error];
+}
+
+- (NSArray *)modelsFromResultDictionaries:(NSArray *)resultDictionaries errorsByIndex:(NSDictionary *__autoreleasing *)errorsByIndex error:(NSError *__autoreleasing *)error {
+    return [self modelsFromResultDictionaries:resultDictionaries propertyKeys:nil errorsByIndex:errorsByIndex error:error];
+}
+
+- (NSArray *)modelsFromResultDictionaries:(NSArray *)resultDictionaries propertyKeys:(NSSet *)propertyKeys errorsByIndex:(NSDictionary *__autoreleasing *)errorsByIndex error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(resultDictionaries);
+
+    NSUInteger count = resultDictionaries.count;
+    NSMutableArray *models = [NSMutableArray arrayWithCapacity:count];
+    NSMutableDictionary *errors = errorsByIndex ? [NSMutableDictionary dictionary] : nil;
+    NSMapTable *adaptersByClass = [NSMapTable strongToStrongObjectsMapTable];
+    NSError *firstError = nil;
+
+    for (NSUInteger chunkStart = 0; chunkStart < count && firstError == nil; chunkStart += ZTSQLiteAdapterBatchSize) {
+        @autoreleasepool {
+            NSUInteger chunkEnd = MIN(chunkStart + ZTSQLiteAdapterBatchSize, count);
+
+            for (NSUInteger idx = chunkStart; idx < chunkEnd; idx++) {
+                NSError *rowError = nil;
+                id model = [self batchModelFromResultDictionary:resultDictionaries[idx] propertyKeys:propertyKeys adaptersByClass:adaptersByClass error:&rowError];
+
+                if (model != nil) {
+                    [models addObject:model];
+                } else if (errors != nil) {
+                    errors[@(idx)] = rowError ?: ZTSQLiteAdapterInvalidRowError();
+                } else {
+                    firstError = rowError ?: ZTSQLiteAdapterInvalidRowError();
+                    break;
+                }
+            }
+        }
+    }
+
+    if (firstError != nil) {
+        if (error) {
+            *error = firstError;
+        }
+        return nil;
+    }
+
+    if (errorsByIndex) {
+        *errorsByIndex = errors.count ? [errors copy] : nil;
+    }
+
+    return models;
+}
+
+- (NSArray *)modelsConcurrentlyFromResultDictionaries:(NSArray *)resultDictionaries propertyKeys:(NSSet *)propertyKeys errorsByIndex:(NSDictionary *__autoreleasing *)errorsByIndex error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(resultDictionaries);
+
+    NSUInteger count = resultDictionaries.count;
+    NSUInteger chunkCount = (count + ZTSQLiteAdapterBatchSize - 1) / ZTSQLiteAdapterBatchSize;
+
+    // Not worth dispatching a single chunk.
+    if (chunkCount < 2) {
+        return [self modelsFromResultDictionaries:resultDictionaries propertyKeys:propertyKeys errorsByIndex:errorsByIndex error:error];
+    }
+
+    // Every row is written by exactly one chunk, so the buffers need no lock.
+    __strong id *models = (__strong id *)calloc(count, sizeof(id));
+    __strong NSError **errors = (__strong NSError **)calloc(count, sizeof(NSError *));
+    @onExit {
+        for (NSUInteger idx = 0; idx < count; idx++) {
+            models[idx] = nil;
+            errors[idx] = nil;
+        }
+        free(models);
+        free(errors);
+    };
+
+    // Without `errorsByIndex`, rows after the first failed row don't need to
+    // be decoded. Rows before it are always decoded, so the error of the first
+    // failed row is reported no matter how chunks are scheduled.
+    BOOL skipsFailedRows = errorsByIndex != NULL;
+    _Atomic(NSUInteger) firstFailedIdx = NSNotFound;
+    _Atomic(NSUInteger) *sharedFirstFailedIdx = &firstFailedIdx;
+
+    dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunkIdx) {
+        @autoreleasepool {
+            // Adapters for subclasses are shared, but the cache isn't.
+            NSMapTable *adaptersByClass = [NSMapTable strongToStrongObjectsMapTable];
+
+            NSUInteger chunkStart = chunkIdx * ZTSQLiteAdapterBatchSize;
+            NSUInteger chunkEnd = MIN(chunkStart + ZTSQLiteAdapterBatchSize, count);
+
+            for (NSUInteger idx = chunkStart; idx < chunkEnd; idx++) {
+                if (!skipsFailedRows && idx > atomic_load_explicit(sharedFirstFailedIdx, memory_order_relaxed)) {
+                    break;
+                }
+
+                NSError *rowError = nil;
+                id model = [self batchModelFromResultDictionary:resultDictionaries[idx] propertyKeys:propertyKeys adaptersByClass:adaptersByClass error:&rowError];
+
+                if (model != nil) {
+                    models[idx] = model;
+                    continue;
+                }
+
+                errors[idx] = rowError ?: ZTSQLiteAdapterInvalidRowError();
+
+                // Lower the first failed index, retrying with the value another
+                // chunk stored in the meantime.
+                NSUInteger failedIdx = atomic_load_explicit(sharedFirstFailedIdx, memory_order_relaxed);
+                while (idx < failedIdx && !atomic_compare_exchange_weak_explicit(sharedFirstFailedIdx, &failedIdx, idx, memory_order_relaxed, memory_order_relaxed)) {
+                    continue;
+                }
+            }
+        }
+    });
+
+    NSUInteger failedIdx = atomic_load_explicit(&firstFailedIdx, memory_order_relaxed);
+    if (!skipsFailedRows && failedIdx != NSNotFound) {
+        if (error) {
+            *error = errors[failedIdx];
+        }
+        return nil;
+    }
+
+    NSMutableArray *result = [NSMutableArray arrayWithCapacity:count];
+    NSMutableDictionary *errorsByRow = [NSMutableDictionary dictionary];
+
+    for (NSUInteger idx = 0; idx < count; idx++) {
+        if (models[idx] != nil) {
+            [result addObject:models[idx]];
+        } else {
+            errorsByRow[@(idx)] = errors[idx];
+        }
+    }
+
+    if (errorsByIndex) {
+        *errorsByIndex = errorsByRow.count ? [errorsByRow copy] : nil;
+    }
+
+    return result;
 }
 
-+ (NSString *)columnDefinitionsOfClass:(Class)modelClass
-{
-    NSParameterAssert(modelClass);
-    NSParameterAssert([modelClass conformsToProtocol:@protocol(ZTSQLiteSerializing)]);
+- (NSArray *)modelsFromStatement:(sqlite3_stmt *)statement errorsByIndex:(NSDictionary *__autoreleasing *)errorsByIndex error:(NSError *__autoreleasing *)error {
+    return [self modelsFromStatement:statement propertyKeys:nil errorsByIndex:errorsByIndex error:error];
+}
 
-    if (![modelClass respondsToSelector:@selector(SQLiteColumnDefinitionsByPropertyKey)]) {
+- (NSArray *)modelsFromStatement:(sqlite3_stmt *)statement propertyKeys:(NSSet *)propertyKeys errorsByIndex:(NSDictionary *__autoreleasing *)errorsByIndex error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(statement != NULL);
+    if (statement == NULL) {
         return nil;
     }
 
-    __block NSMutableString *defs = nil;
-    NSDictionary *columnDefinitionsByPropertyKey = [modelClass SQLiteColumnDefinitionsByPropertyKey];
-    [[modelClass SQLiteColumnNamesByPropertyKey] enumerateKeysAndObjectsUsingBlock:^(NSString* propertyKey, NSString* columnName, BOOL *stop) {
-        if (!defs) {
-            defs = [NSMutableString stringWithFormat:@"(%@", columnName];
-        } else {
-            [defs appendFormat:@", %@", columnName];
+    NSMutableArray *models = [NSMutableArray array];
+    NSMutableDictionary *errors = errorsByIndex ? [NSMutableDictionary dictionary] : nil;
+    NSMapTable *adaptersByClass = [NSMapTable strongToStrongObjectsMapTable];
+    NSError *firstError = nil;
+
+    NSIndexSet *projection = [self projectionForPropertyKeys:propertyKeys];
+    int columnIndexes[MAX(_columnCount, 1)];
+    [self getColumnIndexes:columnIndexes ofStatement:statement projection:projection];
+
+    NSUInteger idx = 0;
+    BOOL done = NO;
+
+    while (!done && firstError == nil) {
+        @autoreleasepool {
+            for (NSUInteger chunkIdx = 0; chunkIdx < ZTSQLiteAdapterBatchSize; chunkIdx++) {
+                int resultCode = sqlite3_step(statement);
+                if (resultCode == SQLITE_DONE) {
+                    done = YES;
+                    break;
+                } else if (resultCode != SQLITE_ROW) {
+                    firstError = ZTSQLiteAdapterStatementFailedError(sqlite3_db_handle(statement), resultCode);
+                    break;
+                }
+
+                NSError *rowError = nil;
+                id model = nil;
+
+                if (self.parsesClassFromResultDictionary) {
+                    model = [self batchModelFromResultDictionary:ZTSQLiteResultDictionaryFromStatement(statement) propertyKeys:propertyKeys adaptersByClass:adaptersByClass error:&rowError];
+                } else {
+                    model = [self modelFromStatement:statement columnIndexes:columnIndexes projection:projection error:&rowError];
+                }
+
+                if (model != nil) {
+                    [models addObject:model];
+                } else if (errors != nil) {
+                    errors[@(idx)] = rowError ?: ZTSQLiteAdapterInvalidRowError();
+                } else {
+                    firstError = rowError ?: ZTSQLiteAdapterInvalidRowError();
+                    break;
+                }
+
+                idx++;
+            }
         }
+    }
 
-        NSString *def = columnDefinitionsByPropertyKey[propertyKey];
-        if (def) {
-            [defs appendFormat:@" %@", def];
+    if (firstError != nil) {
+        if (error) {
+            *error = firstError;
         }
-    }];
+        return nil;
+    }
 
-    [defs appendString:@")"];
-    return [defs copy];
+    if (errorsByIndex) {
+        *errorsByIndex = errors.count ? [errors copy] : nil;
+    }
+
+    return models;
 }
 
-- (instancetype)initWithModelClass:(Class)modelClass {
-    NSParameterAssert(modelClass);
-    NSParameterAssert([modelClass conformsToProtocol:@protocol(ZTSQLiteSerializing)]);
+- (BOOL)enumerateModelsFromStatement:(sqlite3_stmt *)statement propertyKeys:(NSSet *)propertyKeys usingBlock:(void (^)(id, NSUInteger, BOOL *))block error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(statement != NULL);
+    NSParameterAssert(block);
+    if (statement == NULL || block == nil) {
+        return NO;
+    }
 
-    if (self = [super init]) {
-        _modelClass = modelClass;
-        _SQLiteColumnNamesByPropertyKey = [modelClass SQLiteColumnNamesByPropertyKey];
+    NSIndexSet *projection = [self projectionForPropertyKeys:propertyKeys];
+    BOOL parsesClass = self.parsesClassFromResultDictionary;
 
-        NSSet *propertyKeys = [self.modelClass propertyKeys];
-        for (NSString *mappedPropertyKey in self.SQLiteColumnNamesByPropertyKey) {
-            if (![propertyKeys containsObject:mappedPropertyKey]) {
-                NSAssert(NO, @"%@ is not a property of %@.", mappedPropertyKey, modelClass);
-                return nil;
+    int columnIndexes[MAX(_columnCount, 1)];
+    if (!parsesClass) {
+        [self getColumnIndexes:columnIndexes ofStatement:statement projection:projection];
+    }
+
+    // Each chunk takes a slot until it has been passed to the block, which
+    // makes stepping wait for the block when all slots are taken.
+    dispatch_semaphore_t freeSlots = dispatch_semaphore_create(ZTSQLiteAdapterStreamChunkCount);
+    dispatch_group_t decoding = dispatch_group_create();
+    dispatch_queue_t decodingQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    dispatch_queue_t deliveryQueue = dispatch_queue_create("ZTSQLiteAdapter.delivery", DISPATCH_QUEUE_SERIAL);
+
+    // The ring of deserialized chunks waiting for the chunks before them,
+    // indexed by chunk number. Only accessed on the delivery queue, like the
+    // variables below.
+    NSMutableArray *ring = [NSMutableArray arrayWithCapacity:ZTSQLiteAdapterStreamChunkCount];
+    for (NSUInteger idx = 0; idx < ZTSQLiteAdapterStreamChunkCount; idx++) {
+        [ring addObject:[NSNull null]];
+    }
+
+    __block NSUInteger nextChunkNumber = 0;
+    __block NSError *firstError = nil;
+
+    // Set once the block stops the enumeration or a row fails. This method
+    // waits for all blocks using it before returning.
+    _Atomic(BOOL) stopped = NO;
+    _Atomic(BOOL) *sharedStopped = &stopped;
+
+    void (^deliver)(ZTSQLiteRowChunk *) = ^(ZTSQLiteRowChunk *chunk) {
+        ring[chunk.number % ZTSQLiteAdapterStreamChunkCount] = chunk;
+
+        while (YES) {
+            ZTSQLiteRowChunk *nextChunk = ring[nextChunkNumber % ZTSQLiteAdapterStreamChunkCount];
+            if (nextChunk == (id)[NSNull null] || nextChunk.number != nextChunkNumber) {
+                break;
             }
 
-            id value = self.SQLiteColumnNamesByPropertyKey[mappedPropertyKey];
-            if (![value isKindOfClass:NSString.class]) {
-                NSAssert(NO, @"%@ must map to a column name, got: %@.", mappedPropertyKey, value);
-                return nil;
+            ring[nextChunkNumber % ZTSQLiteAdapterStreamChunkCount] = [NSNull null];
+            nextChunkNumber++;
+
+            @autoreleasepool {
+                for (NSUInteger idx = 0; idx < nextChunk.models.count && !atomic_load(sharedStopped); idx++) {
+                    BOOL stop = NO;
+                    block(nextChunk.models[idx], nextChunk.firstRowIndex + idx, &stop);
+
+                    if (stop) {
+                        atomic_store(sharedStopped, YES);
+                    }
+                }
+
+                if (nextChunk.error != nil && !atomic_load(sharedStopped)) {
+                    firstError = nextChunk.error;
+                    atomic_store(sharedStopped, YES);
+                }
             }
+
+            dispatch_semaphore_signal(freeSlots);
         }
+    };
 
-        _valueTransformersByPropertyKey = [self.class valueTransformersForModelClass:modelClass];
-        _SQLiteAdaptersByModelClass = [NSMapTable strongToStrongObjectsMapTable];
-    }
-    return self;
-}
+    void (^decode)(ZTSQLiteRowChunk *) = ^(ZTSQLiteRowChunk *chunk) {
+        dispatch_group_async(decoding, decodingQueue, ^{
+            @autoreleasepool {
+                NSMapTable *adaptersByClass = [NSMapTable strongToStrongObjectsMapTable];
 
-- (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model propertyKeys:(NSSet *)propertyKeys error:(NSError *__autoreleasing *)error {
-    NSMutableDictionary *parameterDictionary = [NSMutableDictionary dictionaryWithCapacity:propertyKeys.count];
+                for (NSUInteger rowIdx = 0; rowIdx < chunk.rowCount && !atomic_load(sharedStopped); rowIdx++) {
+                    NSError *rowError = nil;
+                    id model = nil;
 
-    __block BOOL success = YES;
-    __block NSError *tmpError = nil;
+                    if (parsesClass) {
+                        model = [self batchModelFromResultDictionary:chunk.resultDictionaries[rowIdx] propertyKeys:propertyKeys adaptersByClass:adaptersByClass error:&rowError];
+                    } else {
+                        model = [self modelFromColumnValues:[chunk columnValuesOfRowAtIndex:rowIdx] scalarValues:[chunk scalarValuesOfRowAtIndex:rowIdx] projection:projection resultDictionary:nil error:&rowError];
+                    }
 
-    [propertyKeys enumerateObjectsUsingBlock:^(NSString *propertyKey, BOOL *stop) {
-        id value = model.dictionaryValue[propertyKey];
+                    if (model == nil) {
+                        chunk.error = rowError ?: ZTSQLiteAdapterInvalidRowError();
+                        break;
+                    }
 
-        NSValueTransformer *transformer = self.valueTransformersByPropertyKey[propertyKey];
-        if ([transformer.class allowsReverseTransformation]) {
-            // Map NSNull -> nil for the transformer, and then back for the
-            // dictionaryValue we're going to insert into.
-            if (value == [NSNull null]) {
-                value = nil;
+                    [chunk.models addObject:model];
+                }
             }
 
-            if ([transformer respondsToSelector:@selector(reverseTransformedValue:success:error:)]) {
-                id<MTLTransformerErrorHandling> errorHandlingTransformer = (id)transformer;
+            dispatch_async(deliveryQueue, ^{
+                deliver(chunk);
+            });
+        });
+    };
+
+    NSError *stepError = nil;
+    ZTSQLiteRowChunk *chunk = nil;
+    NSUInteger chunkNumber = 0;
+    NSUInteger rowIdx = 0;
+
+    while (!atomic_load(sharedStopped)) {
+        int resultCode = sqlite3_step(statement);
+        if (resultCode == SQLITE_DONE) {
+            break;
+        } else if (resultCode != SQLITE_ROW) {
+            stepError = ZTSQLiteAdapterStatementFailedError(sqlite3_db_handle(statement), resultCode);
+            break;
+        }
 
-                value = [errorHandlingTransformer reverseTransformedValue:value success:&success error:&tmpError];
-                if (!success) {
-                    *stop = YES;
-                    return;
-                }
-                value = value ?: [NSNull null];
+        if (chunk == nil) {
+            dispatch_semaphore_wait(freeSlots, DISPATCH_TIME_FOREVER);
+            chunk = [[ZTSQLiteRowChunk alloc] initWithNumber:chunkNumber++ firstRowIndex:rowIdx columnCount:_columnCount];
+        }
+
+        @autoreleasepool {
+            if (parsesClass) {
+                [chunk.resultDictionaries addObject:ZTSQLiteResultDictionaryFromStatement(statement)];
             } else {
-                value = [transformer reverseTransformedValue:value] ?: [NSNull null];
+                [self getColumnValues:[chunk columnValuesOfRowAtIndex:chunk.rowCount] scalarValues:[chunk scalarValuesOfRowAtIndex:chunk.rowCount] ofStatement:statement columnIndexes:columnIndexes];
             }
         }
 
-        NSString *key = self.SQLiteColumnNamesByPropertyKey[propertyKey];
-        parameterDictionary[key] = value;
-    }];
+        chunk.rowCount++;
+        rowIdx++;
 
-    if (success) {
-        return parameterDictionary;
-    } else {
+        if (chunk.rowCount == ZTSQLiteAdapterStreamChunkSize) {
+            decode(chunk);
+            chunk = nil;
+        }
+    }
+
+    if (chunk != nil) {
+        decode(chunk);
+    }
+
+    // Deliveries are enqueued before their decoding finishes, so this waits
+    // for the last call of the block.
+    dispatch_group_wait(decoding, DISPATCH_TIME_FOREVER);
+    dispatch_sync(deliveryQueue, ^{});
+
+    NSError *resultError = firstError ?: stepError;
+    if (resultError != nil) {
         if (error) {
-            *error = tmpError;
+            *error = resultError;
         }
-        return nil;
+        return NO;
     }
+
+    return YES;
 }
 
-- (NSString *)whereClauseWithColumnNames:(NSArray *)columnNames {
-    NSMutableArray *whereComponents = [NSMutableArray arrayWithCapacity:columnNames.count];
-    for (NSString *name in columnNames) {
-        [whereComponents addObject:[NSString stringWithFormat:@"%@ = :%@", name, name]];
-    }
-    return [whereComponents componentsJoinedByString:@" AND "];
+- (id)modelFromStatement:(sqlite3_stmt *)statement error:(NSError *__autoreleasing *)error {
+    return [self modelFromStatement:statement propertyKeys:nil error:error];
 }
 
-- (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model insertingIntoTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
-    NSParameterAssert(model);
-    NSParameterAssert([model isKindOfClass:self.modelClass]);
-    NSParameterAssert(tableName);
+- (id)modelFromStatement:(sqlite3_stmt *)statement propertyKeys:(NSSet *)propertyKeys error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(statement != NULL);
+    if (statement == NULL) {
+        return nil;
+    }
 
-    if (self.modelClass != model.class) {
-        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
-        return [otherAdapter parameterDictionaryFromModel:model insertingIntoTable:tableName statement:statement error:error];
+    // The class cluster hook needs a result dictionary anyway.
+    if (self.parsesClassFromResultDictionary) {
+        return [self modelFromResultDictionary:ZTSQLiteResultDictionaryFromStatement(statement) propertyKeys:propertyKeys error:error];
     }
 
-    NSSet *propertyKeysToInsert = [self insertablePropertyKeys:[NSSet setWithArray:self.SQLiteColumnNamesByPropertyKey.allKeys] forModel:model];
+    NSIndexSet *projection = [self projectionForPropertyKeys:propertyKeys];
+    int columnIndexes[MAX(_columnCount, 1)];
 
-    if (statement) {
-        NSArray *columnNames = [self.SQLiteColumnNamesByPropertyKey dictionaryWithValuesForKeys:propertyKeysToInsert.allObjects].allValues;
-        NSMutableArray *parameters = [NSMutableArray arrayWithCapacity:columnNames.count];
-        for (NSString *name in columnNames) {
-            [parameters addObject:[NSString stringWithFormat:@":%@", name]];
-        }
-        *statement = [NSString stringWithFormat:@"INSERT INTO %@ (%@) VALUES (%@);", tableName,
-                      [columnNames componentsJoinedByString:@", "], [parameters componentsJoinedByString:@", "]];
+    ZTSQLiteResolvedColumns *resolvedColumns = self.lastResolvedColumns;
+    if ([resolvedColumns matchesStatement:statement projection:projection]) {
+        [resolvedColumns getColumnIndexes:columnIndexes];
+    } else {
+        [self getColumnIndexes:columnIndexes ofStatement:statement projection:projection];
+        self.lastResolvedColumns = [[ZTSQLiteResolvedColumns alloc] initWithStatement:statement projection:projection columnIndexes:columnIndexes columnCount:_columnCount];
     }
 
-    return [self parameterDictionaryFromModel:model propertyKeys:propertyKeysToInsert error:error];
+    return [self modelFromStatement:statement columnIndexes:columnIndexes projection:projection error:error];
 }
 
-- (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model updatingInTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
-    NSParameterAssert(model);
-    NSParameterAssert([model isKindOfClass:self.modelClass]);
-    NSParameterAssert(tableName);
-
-    if (self.modelClass != model.class) {
-        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
-        return [otherAdapter parameterDictionaryFromModel:model updatingInTable:tableName statement:statement error:error];
+// Resolves the result column of `statement` for every column in the plan.
+//
+// columnIndexes - A buffer of at least `_columnCount` elements. On return, it
+//                 holds the result column index for each column in the plan,
+//                 or -1 if the statement does not return that column or it
+//                 is not part of `projection`.
+// statement     - A prepared statement. This argument must not be NULL.
+// projection    - The column plan indexes to resolve, or nil for all columns.
+- (void)getColumnIndexes:(int *)columnIndexes ofStatement:(sqlite3_stmt *)statement projection:(NSIndexSet *)projection {
+    for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+        columnIndexes[idx] = -1;
     }
 
-    NSSet *propertyKeysToUpdating = [self updatablePropertyKeys:[NSSet setWithArray:self.SQLiteColumnNamesByPropertyKey.allKeys] forModel:model];
-    NSSet *propertyKeysForParameterDictionary = propertyKeysToUpdating;
-
-    if ([model.class respondsToSelector:@selector(propertyKeysForPrimaryKeys)]) {
-        NSSet *propertyKeysForPrimaryKeys = [model.class propertyKeysForPrimaryKeys];
-        propertyKeysForParameterDictionary = [propertyKeysForParameterDictionary setByAddingObjectsFromSet:propertyKeysForPrimaryKeys];
+    // Generated SELECT statements return their columns in plan order, so try
+    // the next expected column before searching the whole plan.
+    NSUInteger expectedIdx = projection ? projection.firstIndex : 0;
 
-        if (propertyKeysForPrimaryKeys.count && statement) {
-            NSArray *columnsToSet = [self.SQLiteColumnNamesByPropertyKey dictionaryWithValuesForKeys:propertyKeysToUpdating.allObjects].allValues;
-            NSMutableArray *setComponents = [NSMutableArray arrayWithCapacity:columnsToSet.count];
-            for (NSString *name in columnsToSet) {
-                [setComponents addObject:[NSString stringWithFormat:@"%@ = :%@", name, name]];
-            }
+    int count = sqlite3_column_count(statement);
+    for (int statementIdx = 0; statementIdx < count; statementIdx++) {
+        const char *name = sqlite3_column_name(statement, statementIdx);
+        if (name == NULL) continue;
 
-            NSArray *columnsForWhere = [self.SQLiteColumnNamesByPropertyKey dictionaryWithValuesForKeys:propertyKeysForPrimaryKeys.allObjects].allValues;
-            NSString *whereClause = [self whereClauseWithColumnNames:columnsForWhere];
+        if (self.columnNamesAreUnique && expectedIdx < _columnCount && strcmp(name, _columns[expectedIdx].columnNameUTF8) == 0) {
+            columnIndexes[expectedIdx] = statementIdx;
+            expectedIdx = projection ? [projection indexGreaterThanIndex:expectedIdx] : expectedIdx + 1;
+            continue;
+        }
 
-            *statement = [NSString stringWithFormat:@"UPDATE %@ SET %@ WHERE %@;", tableName,
-                          [setComponents componentsJoinedByString:@", "], whereClause];
+        // Later result columns win, like they do in a result dictionary.
+        for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+            if (strcmp(name, _columns[idx].columnNameUTF8) == 0 && (projection == nil || [projection containsIndex:idx])) {
+                columnIndexes[idx] = statementIdx;
+            }
         }
     }
+}
 
-    return [self parameterDictionaryFromModel:model propertyKeys:propertyKeysForParameterDictionary error:error];
+// Deserializes a model from the current row of `statement` using column
+// indexes resolved by -getColumnIndexes:ofStatement:projection:.
+- (id)modelFromStatement:(sqlite3_stmt *)statement columnIndexes:(const int *)columnIndexes projection:(NSIndexSet *)projection error:(NSError *__autoreleasing *)error {
+    __strong id *values = (__strong id *)calloc(MAX(_columnCount, 1), sizeof(id));
+    @onExit {
+        for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+            values[idx] = nil;
+        }
+        free(values);
+    };
+
+    ZTSQLiteScalarValue scalarValues[MAX(_columnCount, 1)];
+    [self getColumnValues:values scalarValues:scalarValues ofStatement:statement columnIndexes:columnIndexes];
+
+    return [self modelFromColumnValues:values scalarValues:scalarValues projection:projection resultDictionary:nil error:error];
 }
 
-- (NSDictionary *)parameterDictionaryFromModel:(id<ZTSQLiteSerializing>)model deletingFromTable:(NSString *)tableName statement:(NSString *__autoreleasing *)statement error:(NSError *__autoreleasing *)error {
-    NSParameterAssert(model);
-    NSParameterAssert([model isKindOfClass:self.modelClass]);
-    NSParameterAssert(tableName);
+// Reads the current row of `statement` into buffers of `_columnCount` values
+// in plan order.
+//
+// values        - On return, the raw values of the columns that were not read
+//                 into `scalarValues`, or nil for columns missing from the row.
+// scalarValues  - On return, the unboxed values of INTEGER and REAL columns of
+//                 properties with a scalar setter. Other values have type 0.
+// columnIndexes - Column indexes resolved by -getColumnIndexes:ofStatement:projection:.
+- (void)getColumnValues:(__strong id *)values scalarValues:(ZTSQLiteScalarValue *)scalarValues ofStatement:(sqlite3_stmt *)statement columnIndexes:(const int *)columnIndexes {
+    // Change snapshots and identity map keys are made of boxed values.
+    BOOL decodesScalars = !self.tracksChanges && !self.usesIdentityMap;
+
+    for (NSUInteger idx = 0; idx < _columnCount; idx++) {
+        values[idx] = nil;
+        scalarValues[idx] = (ZTSQLiteScalarValue){ 0 };
+        if (columnIndexes[idx] < 0) continue;
+
+        if (decodesScalars && _columns[idx].scalarSetterImplementation != NULL) {
+            scalarValues[idx] = ZTSQLiteStatementScalarColumnValue(statement, columnIndexes[idx]);
+            if (scalarValues[idx].type != 0) continue;
+        }
 
-    if (self.modelClass != model.class) {
-        ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:model.class error:error];
-        return [otherAdapter parameterDictionaryFromModel:model deletingFromTable:tableName statement:statement error:error];
+        values[idx] = ZTSQLiteStatementColumnValue(statement, columnIndexes[idx]);
     }
+}
 
-    if ([model.class respondsToSelector:@selector(propertyKeysForPrimaryKeys)]) {
-        NSSet *propertyKeysForPrimaryKeys = [model.class propertyKeysForPrimaryKeys];
-
-        if (propertyKeysForPrimaryKeys.count) {
-            if (statement) {
-                NSArray *columnsForWhere = [self.SQLiteColumnNamesByPropertyKey dictionaryWithValuesForKeys:propertyKeysForPrimaryKeys.allObjects].allValues;
-                NSString *whereClause = [self whereClauseWithColumnNames:columnsForWhere];
+// Returns whether the next decoded model should be validated according to the
+// validation policy.
+- (BOOL)shouldValidateDecodedModel {
+    switch (self.validationPolicy) {
+        case ZTSQLiteValidationPolicyAlways:
+            return YES;
 
-                *statement = [NSString stringWithFormat:@"DELETE FROM %@ WHERE %@;", tableName, whereClause];
-            }
+        case ZTSQLiteValidationPolicyDebugOnly:
+            #if DEBUG
+            return YES;
+            #else
+            return NO;
+            #endif
 
-            return [self parameterDictionaryFromModel:model propertyKeys:propertyKeysForPrimaryKeys error:error];
+        case ZTSQLiteValidationPolicySampled: {
+            return atomic_fetch_add_explicit(&_sampledModelCount, 1, memory_order_relaxed) % self.validationSamplingInterval == 0;
         }
+
+        case ZTSQLiteValidationPolicyNever:
+            return NO;
     }
 
-    return nil;
+    return YES;
 }
 
-- (id)modelFromResultDictionary:(NSDictionary *)resultDictionary error:(NSError *__autoreleasing *)error {
-    NSParameterAssert(resultDictionary);
-    NSParameterAssert([resultDictionary isKindOfClass:NSDictionary.class]);
-    if (!resultDictionary) {
-        return nil;
+// Deserializes a model from raw column values.
+//
+// values           - A buffer of `_columnCount` raw column values in plan
+//                    order. Columns missing from the result are nil.
+// scalarValues     - A buffer of `_columnCount` unboxed column values in plan
+//                    order, which take precedence over `values` for columns
+//                    with a scalar setter, or NULL.
+// projection       - The column plan indexes of the properties to decode, or
+//                    nil to decode all properties. Other properties are left
+//                    untouched instead of being decoded from nil.
+// resultDictionary - The result dictionary the values were taken from, if any.
+//                    Only used for logging.
+// error            - If not NULL, this may be set to an error that occurs during
+//                    deserializing or validation.
+//
+// Returns a model object, or nil if a deserialization error occurred or the
+// model did not validate successfully.
+- (id)modelFromColumnValues:(id const __unsafe_unretained *)values scalarValues:(const ZTSQLiteScalarValue *)scalarValues projection:(NSIndexSet *)projection resultDictionary:(NSDictionary *)resultDictionary error:(NSError *__autoreleasing *)error {
+    // Partially decoded models are never shared.
+    NSArray *primaryKey = nil;
+    if (self.usesIdentityMap && projection == nil) {
+        primaryKey = [self primaryKeyWithColumnValues:values];
+
+        id residentModel = primaryKey ? [self residentModelWithPrimaryKey:primaryKey columnValues:values] : nil;
+        if (residentModel != nil) {
+            return residentModel;
+        }
     }
 
-    if ([self.modelClass respondsToSelector:@selector(classForParsingResultDictionary:)]) {
-        Class class = [self.modelClass classForParsingResultDictionary:resultDictionary];
-        if (!class) {
-            if (error) {
-                NSDictionary *userInfo = @{ NSLocalizedDescriptionKey: NSLocalizedString(@"Cloud not parse SQLite result dictionary", @""),
-                                            NSLocalizedFailureReasonErrorKey: NSLocalizedString(@"No model class could be found to parse the SQLite result dictionary.", @"")
-                                            };
+    // Lazy properties are only faulted if there's a value to decode.
+    BOOL faults = NO;
+    for (NSUInteger idx = self.lazyColumnIndexes.firstIndex; idx != NSNotFound; idx = [self.lazyColumnIndexes indexGreaterThanIndex:idx]) {
+        if (values[idx] != nil && (projection == nil || [projection containsIndex:idx])) {
+            faults = YES;
+            break;
+        }
+    }
 
-                *error = [NSError errorWithDomain:ZTSQLiteAdapterErrorDomain code:ZTSQLiteAdapterErrorNoClassFound userInfo:userInfo];
-            }
+    Class modelClass = faults ? self.faultingModelClass : self.modelClass;
+    NSMutableDictionary *lazyColumnValues = faults ? [NSMutableDictionary dictionaryWithCapacity:self.lazyColumnIndexes.count] : nil;
+
+    // Either set the decoded values on the model right away, or collect them
+    // for +modelWithDictionary:error:.
+    id model = nil;
+    NSMutableDictionary *dictionaryValue = nil;
 
+    if (self.assignsPropertiesDirectly) {
+        ZTSQLITE_INSTRUMENT_START(creationStartTime);
+
+        model = [[modelClass alloc] init];
+        if (model == nil) {
             return nil;
         }
 
-        if (class != self.modelClass) {
-            NSAssert([class conformsToProtocol:@protocol(ZTSQLiteSerializing)], @"Class %@ returned from +classForParsingResultDictionary: does not conform to <ZTSQLiteSerializing>", class);
+        ZTSQLITE_INSTRUMENT_END(ZTSQLiteInstrumentationEventModelCreation, creationStartTime);
+    } else {
+        dictionaryValue = [NSMutableDictionary dictionaryWithCapacity:projection ? projection.count : _columnCount];
+    }
 
-            ZTSQLiteAdapter *otherAdapter = [self SQLiteAdapterForModelClass:class error:error];
+    ZTSQLITE_INSTRUMENT_START(transformStartTime);
 
-            return [otherAdapter modelFromResultDictionary:resultDictionary error:error];
-        }
-    }
+    NSUInteger firstIndex = projection ? projection.firstIndex : 0;
+    for (NSUInteger idx = firstIndex; idx != NSNotFound && idx < _columnCount; idx = projection ? [projection indexGreaterThanIndex:idx] : idx + 1) {
+        const ZTSQLiteColumn *column = &_columns[idx];
+        NSString *columnName = column->columnName;
 
-    NSMutableDictionary *dictionaryValue = [NSMutableDictionary dictionaryWithCapacity:resultDictionary.count];
+        id value = values[idx];
 
-    for (NSString *propertyKey in [self.modelClass propertyKeys]) {
-        NSString *columnName = self.SQLiteColumnNamesByPropertyKey[propertyKey];
-        if (!columnName) {
+        // Keep the raw value of lazy properties until they are first read.
+        if (column->lazy && value != nil) {
+            lazyColumnValues[column->propertyKey] = value;
             continue;
         }
 
-        id value = [resultDictionary objectForKey:columnName];
-
         @try {
-            NSValueTransformer *transformer = self.valueTransformersByPropertyKey[propertyKey];
-            if (transformer) {
-                // Map NSNull -> nil for the transformer, and then back for the
-                // dictionary we're going to insert into.
-                if (value == [NSNull null]) {
-                    value = nil;
-                }
-
-                if ([transformer respondsToSelector:@selector(transformedValue:success:error:)]) {
-                    id<MTLTransformerErrorHandling> errorHandlingTransformer = (id)transformer;
-
-                    BOOL success = YES;
-                    value = [errorHandlingTransformer transformedValue:value success:&success error:error];
-
-                    if (!success) {
-                        return nil;
-                    }
-                } else {
-                    value = [transformer transformedValue:value];
-                }
+            // Scalar setters are only found for models that are created
+            // before their properties are set.
+            if (scalarValues != NULL && scalarValues[idx].type != 0) {
+                ZTSQLiteSetScalarColumnValueOfModel(column, model, scalarValues[idx]);
+                continue;
+            }
 
-                if (value == nil) {
-                    value = [NSNull null];
-                }
+            BOOL success = YES;
+            value = ZTSQLiteTransformedColumnValue(column, value, &success, error);
+            if (!success) {
+                ZTSQLITE_INSTRUMENT_COUNT(ZTSQLiteInstrumentationEventTransformerFailure);
+                return nil;
             }
 
-            dictionaryValue[propertyKey] = value;
+            if (model != nil) {
+                ZTSQLiteSetColumnValueOfModel(column, model, value);
+            } else {
+                dictionaryValue[column->propertyKey] = value;
+            }
         } @catch (NSException *ex) {
-            NSLog(@"*** Caught exception %@ parsing column name \"%@\" from: %@", ex, columnName, resultDictionary);
+            NSLog(@"*** Caught exception %@ parsing column name \"%@\" from: %@", ex, columnName, resultDictionary ?: values[idx]);
 
             // Fail fast in Debug builds.
             #if DEBUG
@@ -384,9 +3468,66 @@ static SEL MTLSelectorWithKeyPattern(NSString *key, const char *suffix) {
         }
     }
 
-    id model = [self.modelClass modelWithDictionary:dictionaryValue error:error];
+    ZTSQLITE_INSTRUMENT_END(ZTSQLiteInstrumentationEventDecodeTransform, transformStartTime);
+
+    if (model == nil) {
+        ZTSQLITE_INSTRUMENT_START(creationStartTime);
+
+        if (faults) {
+            model = [[modelClass alloc] initWithDictionary:dictionaryValue error:error];
+        } else {
+            model = [modelClass modelWithDictionary:dictionaryValue error:error];
+        }
+
+        if (model == nil) {
+            return nil;
+        }
+
+        ZTSQLITE_INSTRUMENT_END(ZTSQLiteInstrumentationEventModelCreation, creationStartTime);
+    }
+
+    ZTSQLiteFault *fault = nil;
+    if (faults) {
+        fault = [[ZTSQLiteFault alloc] initWithAdapter:self columnValuesByPropertyKey:lazyColumnValues];
+        objc_setAssociatedObject(model, &ZTSQLiteFaultKey, fault, OBJC_ASSOCIATION_RETAIN);
+    }
+
+    if (projection != nil) {
+        objc_setAssociatedObject(model, &ZTSQLiteProjectionKey, projection, OBJC_ASSOCIATION_RETAIN);
+    }
+
+    if ([self shouldValidateDecodedModel]) {
+        ZTSQLITE_INSTRUMENT_START(validationStartTime);
+
+        BOOL valid = fault != nil ? [self validateDecodedPropertiesOfModel:model fault:fault error:error] : [model validate:error];
+
+        ZTSQLITE_INSTRUMENT_END(ZTSQLiteInstrumentationEventValidation, validationStartTime);
+
+        if (!valid) {
+            return nil;
+        }
+    }
+
+    if (self.tracksChanges || self.usesIdentityMap) {
+        [self recordChangeSnapshotOfModel:model columnValues:values];
+    }
+
+    if (primaryKey != nil) {
+        @synchronized(self.residentModelsByPrimaryKey) {
+            // Another thread may have decoded the same row in the meantime.
+            id residentModel = [self residentModelWithPrimaryKey:primaryKey columnValues:values];
+            if (residentModel != nil) {
+                return residentModel;
+            }
+
+            [self.residentModelsByPrimaryKey setObject:model forKey:primaryKey];
 
-    return [model validate:error] ? model : nil;
+            ZTSQLiteResidentModelEntry *entry = [[ZTSQLiteResidentModelEntry alloc] initWithMap:self.residentModelsByPrimaryKey primaryKey:primaryKey];
+            objc_setAssociatedObject(model, &ZTSQLiteResidentModelEntryKey, entry, OBJC_ASSOCIATION_RETAIN);
+        }
+    }
+
+    return model;
 }
 
 - (NSSet *)insertablePropertyKeys:(NSSet *)propertyKeys forModel:(id<ZTSQLiteSerializing>)model {
@@ -406,21 +3547,9 @@ static SEL MTLSelectorWithKeyPattern(NSString *key, const char *suffix) {
     NSParameterAssert(modelClass);
     NSParameterAssert([modelClass conformsToProtocol:@protocol(ZTSQLiteSerializing)]);
 
-    @synchronized(self) {
-        ZTSQLiteAdapter *result = [self.SQLiteAdaptersByModelClass objectForKey:modelClass];
-
-        if (result != nil) {
-            return result;
-        }
-
-        result = [[ZTSQLiteAdapter alloc] initWithModelClass:modelClass];
+    ZTSQLITE_INSTRUMENT_COUNT(ZTSQLiteInstrumentationEventClassClusterRedirect);
 
-        if (result != nil) {
-            [self.SQLiteAdaptersByModelClass setObject:result forKey:modelClass];
-        }
-
-        return result;
-    }
+    return [self.class adapterForModelClass:modelClass];
 }
 
 + (NSDictionary *)valueTransformersForModelClass:(Class)modelClass {
@@ -430,18 +3559,10 @@ static SEL MTLSelectorWithKeyPattern(NSString *key, const char *suffix) {
     NSMutableDictionary *result = [NSMutableDictionary dictionary];
 
     for (NSString *key in [modelClass propertyKeys]) {
-        SEL selector = MTLSelectorWithKeyPattern(key, "SQLiteColumnTransformer");
-        if ([modelClass respondsToSelector:selector]) {
-            NSInvocation *invocation = [NSInvocation invocationWithMethodSignature:[modelClass methodSignatureForSelector:selector]];
-            invocation.target = modelClass;
-            invocation.selector = selector;
-            [invocation invoke];
-
-            __unsafe_unretained id transformer = nil;
-            [invocation getReturnValue:&transformer];
-
-            if (transformer != nil) {
-                result[key] = transformer;
+        id keyedTransformer = ZTSQLiteKeyedColumnTransformerOfModelClass(modelClass, key);
+        if (keyedTransformer != nil) {
+            if (keyedTransformer != NSNull.null) {
+                result[key] = keyedTransformer;
             }
 
             continue;
@@ -493,19 +3614,43 @@ static SEL MTLSelectorWithKeyPattern(NSString *key, const char *suffix) {
 + (NSValueTransformer *)transformerForModelPropertiesOfClass:(Class)modelClass {
     NSParameterAssert(modelClass);
 
-    SEL selector = MTLSelectorWithKeyPattern(NSStringFromClass(modelClass), "SQLiteColumnTransformer");
-    if (![self respondsToSelector:selector]) {
-        return nil;
+    // Caches the transformers by property class for each adapter class. NSNull
+    // marks property classes without a transformer.
+    static NSMapTable *transformersByAdapterClass = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        transformersByAdapterClass = [NSMapTable strongToStrongObjectsMapTable];
+    });
+
+    NSMapTable *transformersByClass = nil;
+    id result = nil;
+
+    @synchronized(transformersByAdapterClass) {
+        transformersByClass = [transformersByAdapterClass objectForKey:self];
+        if (transformersByClass == nil) {
+            transformersByClass = [NSMapTable strongToStrongObjectsMapTable];
+            [transformersByAdapterClass setObject:transformersByClass forKey:self];
+        }
+
+        result = [transformersByClass objectForKey:modelClass];
     }
-    
-    NSInvocation *invocation = [NSInvocation invocationWithMethodSignature:[self methodSignatureForSelector:selector]];
-    invocation.target = self;
-    invocation.selector = selector;
-    [invocation invoke];
-    
-    __unsafe_unretained id result = nil;
-    [invocation getReturnValue:&result];
-    return result;
+
+    // The transformer method may create adapters or take locks of its own, so
+    // it's called without holding the lock. If another thread raced us, the
+    // transformer it published wins.
+    if (result == nil) {
+        id transformer = ZTSQLiteCallClassMethodWithKeyPattern(self, NSStringFromClass(modelClass), "SQLiteColumnTransformer") ?: NSNull.null;
+
+        @synchronized(transformersByAdapterClass) {
+            result = [transformersByClass objectForKey:modelClass];
+            if (result == nil) {
+                result = transformer;
+                [transformersByClass setObject:result forKey:modelClass];
+            }
+        }
+    }
+
+    return result != NSNull.null ? result : nil;
 }
 
 + (NSValueTransformer *)transformerForModelPropertiesOfObjCType:(const char *)objCType {
@@ -519,3 +3664,80 @@ static SEL MTLSelectorWithKeyPattern(NSString *key, const char *suffix) {
 }
 
 @end
+
+#if ZTSQLITE_INSTRUMENTATION
+
+@implementation ZTSQLiteAdapter (Instrumentation)
+
++ (BOOL)recordsInstrumentation {
+    return atomic_load_explicit(&ZTSQLiteInstrumentationRecording, memory_order_relaxed);
+}
+
++ (void)setRecordsInstrumentation:(BOOL)recordsInstrumentation {
+    @synchronized(ZTSQLiteAdapter.class) {
+        atomic_store_explicit(&ZTSQLiteInstrumentationRecording, recordsInstrumentation, memory_order_relaxed);
+        atomic_store_explicit(&ZTSQLiteInstrumentationActive, recordsInstrumentation || atomic_load_explicit(&ZTSQLiteInstrumentationCallbackSnapshot, memory_order_relaxed) != NULL, memory_order_relaxed);
+    }
+}
+
++ (void)setInstrumentationCallback:(ZTSQLiteInstrumentationCallback)callback context:(void *)context {
+    @synchronized(ZTSQLiteAdapter.class) {
+        ZTSQLiteInstrumentationCallbackEntry *entry = NULL;
+        if (callback != NULL) {
+            entry = malloc(sizeof(ZTSQLiteInstrumentationCallbackEntry));
+            entry->function = callback;
+            entry->context = context;
+            entry->next = NULL;
+        }
+
+        ZTSQLiteInstrumentationCallbackEntry *previousEntry = atomic_exchange(&ZTSQLiteInstrumentationCallbackSnapshot, entry);
+        if (previousEntry != NULL) {
+            previousEntry->next = ZTSQLiteRetiredInstrumentationCallbackEntries;
+            ZTSQLiteRetiredInstrumentationCallbackEntries = previousEntry;
+        }
+
+        // A reader that registers from now on loads `entry` or a later one, so
+        // if none is registered, no reader uses a retired entry. Otherwise they
+        // are freed by a later call.
+        if (atomic_load(&ZTSQLiteInstrumentationCallbackReaderCount) == 0) {
+            while (ZTSQLiteRetiredInstrumentationCallbackEntries != NULL) {
+                ZTSQLiteInstrumentationCallbackEntry *retiredEntry = ZTSQLiteRetiredInstrumentationCallbackEntries;
+                ZTSQLiteRetiredInstrumentationCallbackEntries = retiredEntry->next;
+                free(retiredEntry);
+            }
+        }
+
+        atomic_store_explicit(&ZTSQLiteInstrumentationActive, entry != NULL || atomic_load_explicit(&ZTSQLiteInstrumentationRecording, memory_order_relaxed), memory_order_relaxed);
+    }
+}
+
+- (ZTSQLiteInstrumentationStatistics)instrumentationStatisticsForEvent:(ZTSQLiteInstrumentationEvent)event {
+    NSParameterAssert(event < ZTSQLiteInstrumentationEventCount);
+
+    ZTSQLiteAtomicInstrumentationStatistics *eventStatistics = &_instrumentationStatistics[event];
+
+    ZTSQLiteInstrumentationStatistics statistics;
+    statistics.count = atomic_load_explicit(&eventStatistics->count, memory_order_relaxed);
+    statistics.totalNanoseconds = atomic_load_explicit(&eventStatistics->totalNanoseconds, memory_order_relaxed);
+    for (NSUInteger bucket = 0; bucket < ZTSQLiteInstrumentationHistogramBucketCount; bucket++) {
+        statistics.histogram[bucket] = atomic_load_explicit(&eventStatistics->histogram[bucket], memory_order_relaxed);
+    }
+
+    return statistics;
+}
+
+- (void)resetInstrumentationStatistics {
+    for (NSUInteger event = 0; event < ZTSQLiteInstrumentationEventCount; event++) {
+        ZTSQLiteAtomicInstrumentationStatistics *eventStatistics = &_instrumentationStatistics[event];
+
+        atomic_store_explicit(&eventStatistics->count, 0, memory_order_relaxed);
+        atomic_store_explicit(&eventStatistics->totalNanoseconds, 0, memory_order_relaxed);
+        for (NSUInteger bucket = 0; bucket < ZTSQLiteInstrumentationHistogramBucketCount; bucket++) {
+            atomic_store_explicit(&eventStatistics->histogram[bucket], 0, memory_order_relaxed);
+        }
+    }
+}
+
+@end
+
+#endif
@@ -0,0 +1,82 @@
+//
+//  ZTSQLiteBulkWriter.h
+//  ZTSQLiteAdapter
+//
+//  Copyright (c) 2026 zTap studio. All rights reserved.
+//
+
+@import Foundation;
+
+struct sqlite3;
+
+/// Inserts large numbers of models into a SQLite table.
+///
+/// Models are serialized by ZTSQLiteAdapter into multi-row INSERT statements with
+/// positional parameters on background threads, while the calling thread binds and
+/// executes the statements that are ready, committing a transaction every
+/// `commitSize` rows. Serializing therefore overlaps with SQLite doing the writes.
+///
+/// A writer is not thread-safe, and must be used on the thread the database
+/// connection is used on.
+@interface ZTSQLiteBulkWriter : NSObject
+
+/// Initializes a writer inserting into a table.
+///
+/// database  - An open SQLite database connection. With FMDB, this is
+///             `database.sqliteHandle`. The connection must outlive the writer.
+///             This argument must not be NULL.
+/// tableName - The name of the table to insert into. This argument must not be nil.
+///
+/// Returns an initialized writer.
+- (instancetype)initWithDatabase:(struct sqlite3 *)database tableName:(NSString *)tableName;
+
+/// The name of the table the receiver inserts into.
+@property (nonatomic, copy, readonly) NSString *tableName;
+
+/// The number of rows inserted in each transaction. Defaults to 1000.
+///
+/// If the connection is already in a transaction when writing starts, the writer
+/// doesn't begin or commit transactions and this is ignored.
+@property (nonatomic, assign) NSUInteger commitSize;
+
+/// The number of models serialized by each background task. Defaults to 500.
+@property (nonatomic, assign) NSUInteger encodingBatchSize;
+
+/// The maximum number of serialized batches waiting to be executed. Defaults to 4.
+@property (nonatomic, assign) NSUInteger maximumPendingBatchCount;
+
+/// A block called on the writing thread after every commit, or nil.
+///
+/// rowsWritten - The number of rows inserted so far by the current write.
+/// rowsPerSecond - The average throughput of the current write so far.
+@property (nonatomic, copy) void (^progressHandler)(NSUInteger rowsWritten, double rowsPerSecond);
+
+/// The number of rows inserted by the last write.
+@property (nonatomic, assign, readonly) NSUInteger rowsWritten;
+
+/// The wall-clock duration of the last write.
+@property (nonatomic, assign, readonly) NSTimeInterval duration;
+
+/// The average throughput of the last write in rows per second.
+@property (nonatomic, assign, readonly) double rowsPerSecond;
+
+/// Inserts models into the receiver's table.
+///
+/// If an error occurs, the current transaction is rolled back. Rows committed in
+/// earlier transactions are kept, and `rowsWritten` reports how many there are.
+///
+/// models - The models to insert. All models must be instances of the class of
+///          the first model or of its subclasses. This argument must not be nil.
+/// error  - If not NULL, this may be set to an error that occurs during serializing
+///          or executing.
+///
+/// Returns whether all models were inserted.
+- (BOOL)writeModels:(NSArray *)models error:(NSError **)error;
+
+@end
+
+@interface ZTSQLiteBulkWriter (Deprecated)
+
+- (instancetype)init __attribute__((unavailable("Use -initWithDatabase:tableName: instead")));
+
+@end
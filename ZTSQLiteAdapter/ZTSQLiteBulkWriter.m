@@ -0,0 +1,293 @@
+//
+//  ZTSQLiteBulkWriter.m
+//  ZTSQLiteAdapter
+//
+//  Copyright (c) 2026 zTap studio. All rights reserved.
+//
+
+#import "ZTSQLiteBulkWriter.h"
+#import "ZTSQLiteAdapter.h"
+#import "EXTScope.h"
+#import <sqlite3.h>
+
+// The statements and parameter arrays serialized from one batch of models.
+@interface ZTSQLiteEncodedBatch : NSObject
+
+@property (nonatomic, assign) NSUInteger rowCount;
+@property (nonatomic, copy) NSArray *statements;
+@property (nonatomic, copy) NSArray *parameterArrays;
+@property (nonatomic, strong) NSError *error;
+
+// Signaled once the batch has been serialized, successfully or not.
+@property (nonatomic, strong, readonly) dispatch_semaphore_t serialized;
+
+@end
+
+@implementation ZTSQLiteEncodedBatch
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _serialized = dispatch_semaphore_create(0);
+    }
+
+    return self;
+}
+
+@end
+
+@interface ZTSQLiteBulkWriter ()
+
+@property (nonatomic, assign, readwrite) NSUInteger rowsWritten;
+@property (nonatomic, assign, readwrite) NSTimeInterval duration;
+@property (nonatomic, assign, readwrite) double rowsPerSecond;
+
+@end
+
+@implementation ZTSQLiteBulkWriter {
+    sqlite3 *_database;
+
+    // Prepared statements wrapped in NSValues, keyed by their SQL. Statements
+    // are only cached for the duration of a write.
+    NSMutableDictionary *_preparedStatements;
+}
+
+#pragma mark Lifecycle
+
+- (instancetype)initWithDatabase:(struct sqlite3 *)database tableName:(NSString *)tableName {
+    NSParameterAssert(database != NULL);
+    NSParameterAssert(tableName);
+
+    if (self = [super init]) {
+        _database = database;
+        _tableName = [tableName copy];
+        _commitSize = 1000;
+        _encodingBatchSize = 500;
+        _maximumPendingBatchCount = 4;
+        _preparedStatements = [NSMutableDictionary dictionary];
+    }
+
+    return self;
+}
+
+#pragma mark Writing
+
+- (BOOL)writeModels:(NSArray *)models error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(models);
+
+    self.rowsWritten = 0;
+    self.duration = 0;
+    self.rowsPerSecond = 0;
+
+    if (models.count == 0) return YES;
+
+    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+
+    // Only manage transactions when the caller isn't in one already.
+    BOOL managesTransactions = sqlite3_get_autocommit(_database) != 0;
+
+    NSUInteger batchSize = MAX(self.encodingBatchSize, (NSUInteger)1);
+    NSUInteger batchCount = (models.count + batchSize - 1) / batchSize;
+    NSUInteger pendingBatchCount = MIN(MAX(self.maximumPendingBatchCount, (NSUInteger)1), batchCount);
+    NSUInteger commitSize = MAX(self.commitSize, (NSUInteger)1);
+    NSString *tableName = self.tableName;
+
+    // Batches are dequeued in order. At most `pendingBatchCount` of them are
+    // serializing or waiting to be executed, which bounds the memory held by
+    // serialized parameters.
+    NSMutableArray *pendingBatches = [NSMutableArray arrayWithCapacity:pendingBatchCount];
+    dispatch_queue_t encodingQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+
+    void (^enqueueBatchAtIndex)(NSUInteger) = ^(NSUInteger batchIdx) {
+        NSRange range = NSMakeRange(batchIdx * batchSize, MIN(batchSize, models.count - batchIdx * batchSize));
+        NSArray *batchModels = [models subarrayWithRange:range];
+
+        ZTSQLiteEncodedBatch *batch = [[ZTSQLiteEncodedBatch alloc] init];
+        batch.rowCount = range.length;
+        [pendingBatches addObject:batch];
+
+        dispatch_async(encodingQueue, ^{
+            @autoreleasepool {
+                NSArray *statements = nil;
+                NSError *encodingError = nil;
+                batch.parameterArrays = [ZTSQLiteAdapter parameterArraysFromModels:batchModels insertingIntoTable:tableName statements:&statements error:&encodingError];
+                batch.statements = statements;
+                batch.error = encodingError;
+            }
+
+            dispatch_semaphore_signal(batch.serialized);
+        });
+    };
+
+    for (NSUInteger batchIdx = 0; batchIdx < pendingBatchCount; batchIdx++) {
+        enqueueBatchAtIndex(batchIdx);
+    }
+
+    @onExit {
+        [self finalizePreparedStatements];
+    };
+
+    BOOL inTransaction = NO;
+    NSUInteger rowsInTransaction = 0;
+    __block NSError *writeError = nil;
+
+    for (NSUInteger batchIdx = 0; batchIdx < batchCount; batchIdx++) {
+        @autoreleasepool {
+            ZTSQLiteEncodedBatch *batch = pendingBatches.firstObject;
+            dispatch_semaphore_wait(batch.serialized, DISPATCH_TIME_FOREVER);
+            [pendingBatches removeObjectAtIndex:0];
+
+            if (batchIdx + pendingBatchCount < batchCount) {
+                enqueueBatchAtIndex(batchIdx + pendingBatchCount);
+            }
+
+            if (batch.parameterArrays == nil) {
+                writeError = batch.error ?: ZTSQLiteAdapterInvalidRowError();
+                break;
+            }
+
+            if (managesTransactions && !inTransaction) {
+                if (![self executeSQL:@"BEGIN TRANSACTION" error:&writeError]) break;
+                inTransaction = YES;
+            }
+
+            [batch.statements enumerateObjectsUsingBlock:^(NSString *SQL, NSUInteger idx, BOOL *stop) {
+                NSError *statementError = nil;
+                if (![self executeStatement:SQL withParameters:batch.parameterArrays[idx] error:&statementError]) {
+                    writeError = statementError;
+                    *stop = YES;
+                }
+            }];
+
+            if (writeError != nil) break;
+
+            if (!managesTransactions) {
+                self.rowsWritten += batch.rowCount;
+                continue;
+            }
+
+            rowsInTransaction += batch.rowCount;
+
+            // Transactions end on batch boundaries, so they may hold more than
+            // `commitSize` rows.
+            if (rowsInTransaction >= commitSize) {
+                if (![self executeSQL:@"COMMIT TRANSACTION" error:&writeError]) break;
+                inTransaction = NO;
+
+                [self didCommitRowCount:rowsInTransaction startTime:startTime];
+                rowsInTransaction = 0;
+            }
+        }
+    }
+
+    if (writeError == nil && inTransaction) {
+        if ([self executeSQL:@"COMMIT TRANSACTION" error:&writeError]) {
+            inTransaction = NO;
+
+            [self didCommitRowCount:rowsInTransaction startTime:startTime];
+        }
+    }
+
+    if (writeError != nil && inTransaction) {
+        [self executeSQL:@"ROLLBACK TRANSACTION" error:NULL];
+    }
+
+    [self updateStatisticsWithStartTime:startTime];
+
+    // Batches enqueued ahead may still be serializing models the caller is
+    // free to mutate once this method returns, so wait for them before
+    // discarding them.
+    for (ZTSQLiteEncodedBatch *batch in pendingBatches) {
+        dispatch_semaphore_wait(batch.serialized, DISPATCH_TIME_FOREVER);
+    }
+
+    if (writeError != nil) {
+        if (error) {
+            *error = writeError;
+        }
+        return NO;
+    }
+
+    return YES;
+}
+
+- (void)didCommitRowCount:(NSUInteger)rowCount startTime:(CFAbsoluteTime)startTime {
+    self.rowsWritten += rowCount;
+    [self updateStatisticsWithStartTime:startTime];
+
+    if (self.progressHandler != nil) {
+        self.progressHandler(self.rowsWritten, self.rowsPerSecond);
+    }
+}
+
+- (void)updateStatisticsWithStartTime:(CFAbsoluteTime)startTime {
+    self.duration = CFAbsoluteTimeGetCurrent() - startTime;
+    self.rowsPerSecond = self.duration > 0 ? self.rowsWritten / self.duration : 0;
+}
+
+#pragma mark Statements
+
+- (BOOL)executeSQL:(NSString *)SQL error:(NSError *__autoreleasing *)error {
+    int resultCode = sqlite3_exec(_database, SQL.UTF8String, NULL, NULL, NULL);
+
+    if (resultCode != SQLITE_OK) {
+        if (error) {
+            *error = ZTSQLiteAdapterStatementFailedError(_database, resultCode);
+        }
+        return NO;
+    }
+
+    return YES;
+}
+
+- (BOOL)executeStatement:(NSString *)SQL withParameters:(NSArray *)parameters error:(NSError *__autoreleasing *)error {
+    sqlite3_stmt *statement = [self preparedStatementForSQL:SQL error:error];
+    if (statement == NULL) return NO;
+
+    @onExit {
+        sqlite3_reset(statement);
+        sqlite3_clear_bindings(statement);
+    };
+
+    if (![ZTSQLiteAdapter bindParameters:parameters toStatement:statement error:error]) return NO;
+
+    int resultCode = sqlite3_step(statement);
+    if (resultCode != SQLITE_DONE) {
+        if (error) {
+            *error = ZTSQLiteAdapterStatementFailedError(_database, resultCode);
+        }
+        return NO;
+    }
+
+    return YES;
+}
+
+- (sqlite3_stmt *)preparedStatementForSQL:(NSString *)SQL error:(NSError *__autoreleasing *)error {
+    NSValue *cachedStatement = _preparedStatements[SQL];
+    if (cachedStatement != nil) return cachedStatement.pointerValue;
+
+    sqlite3_stmt *statement = NULL;
+    int resultCode = sqlite3_prepare_v2(_database, SQL.UTF8String, -1, &statement, NULL);
+
+    if (resultCode != SQLITE_OK) {
+        sqlite3_finalize(statement);
+
+        if (error) {
+            *error = ZTSQLiteAdapterStatementFailedError(_database, resultCode);
+        }
+        return NULL;
+    }
+
+    _preparedStatements[SQL] = [NSValue valueWithPointer:statement];
+
+    return statement;
+}
+
+- (void)finalizePreparedStatements {
+    for (NSValue *statement in _preparedStatements.allValues) {
+        sqlite3_finalize(statement.pointerValue);
+    }
+
+    [_preparedStatements removeAllObjects];
+}
+
+@end
@@ -0,0 +1,412 @@
+//
+//  ZTSQLiteAdapterBenchmarks.m
+//  ZTSQLiteAdapterBenchmarks
+//
+//  Copyright (c) 2026 zTap. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import <ZTSQLiteAdapter/ZTSQLiteAdapter.h>
+#import <malloc/malloc.h>
+
+// The number of rows each benchmark processes per iteration. Keep these fixed
+// so results stay comparable across commits.
+static const NSUInteger ZTSQLiteBenchmarkRowCount = 1000;
+static const NSUInteger ZTSQLiteBenchmarkAdapterCount = 100;
+
+#pragma mark Memory
+
+// Returns the number of bytes allocated in all malloc zones, including those
+// of other threads of the test process.
+static int64_t ZTSQLiteBenchmarkBytesInUse(void) {
+    malloc_statistics_t statistics;
+    malloc_zone_statistics(NULL, &statistics);
+    return (int64_t)statistics.size_in_use;
+}
+
+#pragma mark Transformers
+
+// Stores dates as seconds since 1970.
+static NSValueTransformer *ZTSQLiteBenchmarkDateTransformer(void) {
+    static NSValueTransformer *transformer = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        transformer = [MTLValueTransformer transformerUsingForwardBlock:^id(NSNumber *value, BOOL *success, NSError *__autoreleasing *error) {
+            return [NSDate dateWithTimeIntervalSince1970:value.doubleValue];
+        } reverseBlock:^id(NSDate *date, BOOL *success, NSError *__autoreleasing *error) {
+            return @(date.timeIntervalSince1970);
+        }];
+    });
+
+    return transformer;
+}
+
+// Stores UUIDs as 16 byte blobs.
+static NSValueTransformer *ZTSQLiteBenchmarkUUIDTransformer(void) {
+    static NSValueTransformer *transformer = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        transformer = [MTLValueTransformer transformerUsingForwardBlock:^id(NSData *data, BOOL *success, NSError *__autoreleasing *error) {
+            return [[NSUUID alloc] initWithUUIDBytes:data.bytes];
+        } reverseBlock:^id(NSUUID *UUID, BOOL *success, NSError *__autoreleasing *error) {
+            uuid_t bytes;
+            [UUID getUUIDBytes:bytes];
+            return [NSData dataWithBytes:bytes length:sizeof(bytes)];
+        }];
+    });
+
+    return transformer;
+}
+
+#pragma mark Models
+
+// Every group adds five columns: two default-transformed scalars, a string,
+// a date and a blob.
+#define ZTSQLITE_BENCHMARK_PROPERTIES(n) \
+    @property (nonatomic, assign) int64_t integer##n; \
+    @property (nonatomic, assign) double real##n; \
+    @property (nonatomic, copy) NSString *text##n; \
+    @property (nonatomic, copy) NSDate *date##n; \
+    @property (nonatomic, copy) NSUUID *uuid##n;
+
+#define ZTSQLITE_BENCHMARK_TRANSFORMERS(n) \
+    + (NSValueTransformer *)date##n##SQLiteColumnTransformer { return ZTSQLiteBenchmarkDateTransformer(); } \
+    + (NSValueTransformer *)uuid##n##SQLiteColumnTransformer { return ZTSQLiteBenchmarkUUIDTransformer(); }
+
+static NSString * const ZTSQLiteBenchmarkGroupKeyFormats[] = { @"integer%lu", @"real%lu", @"text%lu", @"date%lu", @"uuid%lu" };
+static const NSUInteger ZTSQLiteBenchmarkGroupSize = sizeof(ZTSQLiteBenchmarkGroupKeyFormats) / sizeof(*ZTSQLiteBenchmarkGroupKeyFormats);
+
+// A model with 5 columns.
+@interface ZTSQLiteBenchmarkModel5 : MTLModel <ZTSQLiteSerializing>
+
+ZTSQLITE_BENCHMARK_PROPERTIES(0)
+
+// The number of column groups of the receiver.
++ (NSUInteger)columnGroupCount;
+
+@end
+
+// A model with 20 columns.
+@interface ZTSQLiteBenchmarkModel20 : ZTSQLiteBenchmarkModel5
+
+ZTSQLITE_BENCHMARK_PROPERTIES(1)
+ZTSQLITE_BENCHMARK_PROPERTIES(2)
+ZTSQLITE_BENCHMARK_PROPERTIES(3)
+
+@end
+
+// A model with 80 columns.
+@interface ZTSQLiteBenchmarkModel80 : ZTSQLiteBenchmarkModel20
+
+ZTSQLITE_BENCHMARK_PROPERTIES(4)
+ZTSQLITE_BENCHMARK_PROPERTIES(5)
+ZTSQLITE_BENCHMARK_PROPERTIES(6)
+ZTSQLITE_BENCHMARK_PROPERTIES(7)
+ZTSQLITE_BENCHMARK_PROPERTIES(8)
+ZTSQLITE_BENCHMARK_PROPERTIES(9)
+ZTSQLITE_BENCHMARK_PROPERTIES(10)
+ZTSQLITE_BENCHMARK_PROPERTIES(11)
+ZTSQLITE_BENCHMARK_PROPERTIES(12)
+ZTSQLITE_BENCHMARK_PROPERTIES(13)
+ZTSQLITE_BENCHMARK_PROPERTIES(14)
+ZTSQLITE_BENCHMARK_PROPERTIES(15)
+
+@end
+
+// The abstract base of a class cluster with 5 columns. Rows with an even
+// `integer0` are parsed as ZTSQLiteBenchmarkEvenModel, others as
+// ZTSQLiteBenchmarkOddModel.
+@interface ZTSQLiteBenchmarkClusterModel : ZTSQLiteBenchmarkModel5
+@end
+
+@interface ZTSQLiteBenchmarkEvenModel : ZTSQLiteBenchmarkClusterModel
+@end
+
+@interface ZTSQLiteBenchmarkOddModel : ZTSQLiteBenchmarkClusterModel
+@end
+
+@implementation ZTSQLiteBenchmarkModel5
+
+ZTSQLITE_BENCHMARK_TRANSFORMERS(0)
+
++ (NSUInteger)columnGroupCount {
+    return 1;
+}
+
++ (NSDictionary *)SQLiteColumnNamesByPropertyKey {
+    NSMutableDictionary *columnNames = [NSMutableDictionary dictionary];
+    for (NSUInteger group = 0; group < self.columnGroupCount; group++) {
+        for (NSUInteger idx = 0; idx < ZTSQLiteBenchmarkGroupSize; idx++) {
+            NSString *key = [NSString stringWithFormat:ZTSQLiteBenchmarkGroupKeyFormats[idx], (unsigned long)group];
+            columnNames[key] = key;
+        }
+    }
+
+    return columnNames;
+}
+
++ (NSSet *)propertyKeysForPrimaryKeys {
+    return [NSSet setWithObject:@"integer0"];
+}
+
+@end
+
+@implementation ZTSQLiteBenchmarkModel20
+
+ZTSQLITE_BENCHMARK_TRANSFORMERS(1)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(2)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(3)
+
++ (NSUInteger)columnGroupCount {
+    return 4;
+}
+
+@end
+
+@implementation ZTSQLiteBenchmarkModel80
+
+ZTSQLITE_BENCHMARK_TRANSFORMERS(4)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(5)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(6)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(7)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(8)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(9)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(10)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(11)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(12)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(13)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(14)
+ZTSQLITE_BENCHMARK_TRANSFORMERS(15)
+
++ (NSUInteger)columnGroupCount {
+    return 16;
+}
+
+@end
+
+@implementation ZTSQLiteBenchmarkClusterModel
+
++ (Class)classForParsingResultDictionary:(NSDictionary *)resultDictionary {
+    return [resultDictionary[@"integer0"] longLongValue] % 2 == 0 ? ZTSQLiteBenchmarkEvenModel.class : ZTSQLiteBenchmarkOddModel.class;
+}
+
+@end
+
+@implementation ZTSQLiteBenchmarkEvenModel
+@end
+
+@implementation ZTSQLiteBenchmarkOddModel
+@end
+
+#pragma mark Benchmarks
+
+// Measures the throughput of the adapter's hot paths on synthetic models.
+// Benchmarks live in their own test bundle, which the ZTSQLiteAdapterBenchmarks
+// scheme runs in the Release configuration, so they don't slow down unit tests.
+//
+// Besides the time XCTest records for each test, every benchmark logs a line
+//
+//   ZTSQLiteBenchmark <operation> <class> columns=<n> rows/sec=<n> bytes/row=<n>
+//
+// averaged over all iterations. bytes/row is how much the heap grew while the
+// operation ran, before its autorelease pool was drained. Row data is deterministic, so the numbers of
+// two commits measured on the same device can be compared directly.
+@interface ZTSQLiteAdapterBenchmarks : XCTestCase
+
+@end
+
+@implementation ZTSQLiteAdapterBenchmarks
+
+#pragma mark Fixtures
+
+// Returns `ZTSQLiteBenchmarkRowCount` result dictionaries with the columns of
+// `modelClass`. Every row has a unique `integer0`.
+- (NSArray *)resultDictionariesForModelClass:(Class)modelClass {
+    NSUInteger groupCount = [modelClass columnGroupCount];
+    NSMutableArray *resultDictionaries = [NSMutableArray arrayWithCapacity:ZTSQLiteBenchmarkRowCount];
+
+    for (NSUInteger row = 0; row < ZTSQLiteBenchmarkRowCount; row++) {
+        NSMutableDictionary *resultDictionary = [NSMutableDictionary dictionaryWithCapacity:groupCount * ZTSQLiteBenchmarkGroupSize];
+
+        for (NSUInteger group = 0; group < groupCount; group++) {
+            unsigned char UUIDBytes[16] = { 0 };
+            memcpy(UUIDBytes, &row, MIN(sizeof(row), sizeof(UUIDBytes)));
+            UUIDBytes[15] = (unsigned char)group;
+
+            resultDictionary[[NSString stringWithFormat:@"integer%lu", (unsigned long)group]] = @(row * groupCount + group);
+            resultDictionary[[NSString stringWithFormat:@"real%lu", (unsigned long)group]] = @(row + group / 100.0);
+            resultDictionary[[NSString stringWithFormat:@"text%lu", (unsigned long)group]] = [NSString stringWithFormat:@"Row %lu, column group %lu", (unsigned long)row, (unsigned long)group];
+            resultDictionary[[NSString stringWithFormat:@"date%lu", (unsigned long)group]] = @(1429056000.0 + row * 60 + group);
+            resultDictionary[[NSString stringWithFormat:@"uuid%lu", (unsigned long)group]] = [NSData dataWithBytes:UUIDBytes length:sizeof(UUIDBytes)];
+        }
+
+        [resultDictionaries addObject:resultDictionary];
+    }
+
+    return resultDictionaries;
+}
+
+- (NSArray *)modelsOfClass:(Class)modelClass {
+    NSError *error = nil;
+    NSArray *models = [ZTSQLiteAdapter modelsOfClass:modelClass fromResultDictionaries:[self resultDictionariesForModelClass:modelClass] error:&error];
+    XCTAssertNotNil(models, @"%@", error);
+
+    return models;
+}
+
+#pragma mark Measuring
+
+// Runs `block` under -measureBlock:, and logs the average throughput and
+// heap growth per row of all iterations.
+- (void)measureOperation:(NSString *)operation ofModelClass:(Class)modelClass rowCount:(NSUInteger)rowCount usingBlock:(void (^)(void))block {
+    __block CFAbsoluteTime duration = 0;
+    __block int64_t byteCount = 0;
+    __block NSUInteger iterationCount = 0;
+
+    [self measureBlock:^{
+        @autoreleasepool {
+            int64_t bytesBefore = ZTSQLiteBenchmarkBytesInUse();
+            CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+
+            block();
+
+            duration += CFAbsoluteTimeGetCurrent() - startTime;
+            byteCount += ZTSQLiteBenchmarkBytesInUse() - bytesBefore;
+        }
+
+        iterationCount++;
+    }];
+
+    NSUInteger totalRowCount = rowCount * iterationCount;
+    double rowsPerSecond = duration > 0 ? totalRowCount / duration : 0;
+    double bytesPerRow = (double)byteCount / MAX(totalRowCount, (NSUInteger)1);
+
+    NSLog(@"ZTSQLiteBenchmark %@ %@ columns=%lu rows/sec=%.0f bytes/row=%.0f", operation, modelClass, (unsigned long)[modelClass SQLiteColumnNamesByPropertyKey].count, rowsPerSecond, bytesPerRow);
+}
+
+- (void)measureDecodingModelsOfClass:(Class)modelClass {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:modelClass];
+    NSArray *resultDictionaries = [self resultDictionariesForModelClass:modelClass];
+
+    [self measureOperation:@"decode" ofModelClass:modelClass rowCount:resultDictionaries.count usingBlock:^{
+        NSError *error = nil;
+        NSArray *models = [adapter modelsFromResultDictionaries:resultDictionaries errorsByIndex:NULL error:&error];
+        XCTAssertEqual(models.count, resultDictionaries.count, @"%@", error);
+    }];
+}
+
+- (void)measureEncodingModelsOfClass:(Class)modelClass operation:(NSString *)operation usingBlock:(NSArray *(^)(ZTSQLiteAdapter *adapter, id model, NSError **error))block {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:modelClass];
+    NSArray *models = [self modelsOfClass:modelClass];
+
+    [self measureOperation:operation ofModelClass:modelClass rowCount:models.count usingBlock:^{
+        for (id model in models) {
+            NSError *error = nil;
+            XCTAssertNotNil(block(adapter, model, &error), @"%@", error);
+        }
+    }];
+}
+
+- (void)measureInsertingModelsOfClass:(Class)modelClass {
+    [self measureEncodingModelsOfClass:modelClass operation:@"insert" usingBlock:^(ZTSQLiteAdapter *adapter, id model, NSError **error) {
+        return [adapter parameterArrayFromModel:model insertingIntoTable:@"benchmark" statement:NULL error:error];
+    }];
+}
+
+- (void)measureUpdatingModelsOfClass:(Class)modelClass {
+    [self measureEncodingModelsOfClass:modelClass operation:@"update" usingBlock:^(ZTSQLiteAdapter *adapter, id model, NSError **error) {
+        return [adapter parameterArrayFromModel:model updatingInTable:@"benchmark" statement:NULL error:error];
+    }];
+}
+
+- (void)measureDeletingModelsOfClass:(Class)modelClass {
+    [self measureEncodingModelsOfClass:modelClass operation:@"delete" usingBlock:^(ZTSQLiteAdapter *adapter, id model, NSError **error) {
+        return [adapter parameterArrayFromModel:model deletingFromTable:@"benchmark" statement:NULL error:error];
+    }];
+}
+
+- (void)measureCreatingAdaptersForModelClass:(Class)modelClass {
+    [self measureOperation:@"create-adapter" ofModelClass:modelClass rowCount:ZTSQLiteBenchmarkAdapterCount usingBlock:^{
+        for (NSUInteger idx = 0; idx < ZTSQLiteBenchmarkAdapterCount; idx++) {
+            XCTAssertNotNil([[ZTSQLiteAdapter alloc] initWithModelClass:modelClass]);
+        }
+    }];
+}
+
+#pragma mark Decoding
+
+- (void)testDecodingModelsWith5Columns {
+    [self measureDecodingModelsOfClass:ZTSQLiteBenchmarkModel5.class];
+}
+
+- (void)testDecodingModelsWith20Columns {
+    [self measureDecodingModelsOfClass:ZTSQLiteBenchmarkModel20.class];
+}
+
+- (void)testDecodingModelsWith80Columns {
+    [self measureDecodingModelsOfClass:ZTSQLiteBenchmarkModel80.class];
+}
+
+#pragma mark Encoding
+
+- (void)testInsertingModelsWith5Columns {
+    [self measureInsertingModelsOfClass:ZTSQLiteBenchmarkModel5.class];
+}
+
+- (void)testInsertingModelsWith20Columns {
+    [self measureInsertingModelsOfClass:ZTSQLiteBenchmarkModel20.class];
+}
+
+- (void)testInsertingModelsWith80Columns {
+    [self measureInsertingModelsOfClass:ZTSQLiteBenchmarkModel80.class];
+}
+
+- (void)testUpdatingModelsWith5Columns {
+    [self measureUpdatingModelsOfClass:ZTSQLiteBenchmarkModel5.class];
+}
+
+- (void)testUpdatingModelsWith20Columns {
+    [self measureUpdatingModelsOfClass:ZTSQLiteBenchmarkModel20.class];
+}
+
+- (void)testUpdatingModelsWith80Columns {
+    [self measureUpdatingModelsOfClass:ZTSQLiteBenchmarkModel80.class];
+}
+
+- (void)testDeletingModelsWith5Columns {
+    [self measureDeletingModelsOfClass:ZTSQLiteBenchmarkModel5.class];
+}
+
+- (void)testDeletingModelsWith20Columns {
+    [self measureDeletingModelsOfClass:ZTSQLiteBenchmarkModel20.class];
+}
+
+- (void)testDeletingModelsWith80Columns {
+    [self measureDeletingModelsOfClass:ZTSQLiteBenchmarkModel80.class];
+}
+
+#pragma mark Adapter creation
+
+- (void)testCreatingAdaptersWith5Columns {
+    [self measureCreatingAdaptersForModelClass:ZTSQLiteBenchmarkModel5.class];
+}
+
+- (void)testCreatingAdaptersWith20Columns {
+    [self measureCreatingAdaptersForModelClass:ZTSQLiteBenchmarkModel20.class];
+}
+
+- (void)testCreatingAdaptersWith80Columns {
+    [self measureCreatingAdaptersForModelClass:ZTSQLiteBenchmarkModel80.class];
+}
+
+#pragma mark Class clusters
+
+- (void)testDecodingClassClusterModels {
+    [self measureDecodingModelsOfClass:ZTSQLiteBenchmarkClusterModel.class];
+}
+
+- (void)testInsertingClassClusterModels {
+    [self measureInsertingModelsOfClass:ZTSQLiteBenchmarkClusterModel.class];
+}
+
+@end
@@ -6,35 +6,975 @@
 //  Copyright (c) 2015年 zTap. All rights reserved.
 //
 
-#import <UIKit/UIKit.h>
 #import <XCTest/XCTest.h>
+#import <ZTSQLiteAdapter/ZTSQLiteAdapter.h>
+#import <sqlite3.h>
+#import <stdatomic.h>
+
+static NSString * const ZTSQLiteTestsErrorDomain = @"ZTSQLiteTestsErrorDomain";
+
+#pragma mark Models
+
+// A row of the `items` table. Rows with a negative quantity fail validation
+// with an error whose code is the item ID.
+@interface ZTSQLiteTestItem : MTLModel <ZTSQLiteSerializing>
+
+@property (nonatomic, assign) int64_t itemID;
+@property (nonatomic, copy) NSString *name;
+@property (nonatomic, assign) int64_t quantity;
+
+@end
+
+@implementation ZTSQLiteTestItem
+
++ (NSDictionary *)SQLiteColumnNamesByPropertyKey {
+    return @{
+        @"itemID": @"item_id",
+        @"name": @"name",
+        @"quantity": @"quantity",
+    };
+}
+
++ (NSSet *)propertyKeysForPrimaryKeys {
+    return [NSSet setWithObject:@"itemID"];
+}
+
++ (BOOL)tracksSQLiteChanges {
+    return YES;
+}
+
+- (BOOL)validateQuantity:(inout id *)ioValue error:(out NSError *__autoreleasing *)error {
+    int64_t quantity = [*ioValue longLongValue];
+    if (quantity >= 0) return YES;
+
+    if (error) {
+        *error = [NSError errorWithDomain:ZTSQLiteTestsErrorDomain code:(NSInteger)-quantity userInfo:nil];
+    }
+    return NO;
+}
+
+@end
+
+// An item whose -validate: also rejects empty names, which property
+// validation during initialization doesn't check.
+@interface ZTSQLiteTestNamedItem : ZTSQLiteTestItem
+
+@end
+
+@implementation ZTSQLiteTestNamedItem
+
+- (BOOL)validate:(NSError *__autoreleasing *)error {
+    if (self.name.length == 0) {
+        if (error) {
+            *error = [NSError errorWithDomain:ZTSQLiteTestsErrorDomain code:(NSInteger)self.itemID userInfo:nil];
+        }
+        return NO;
+    }
+
+    return [super validate:error];
+}
+
+@end
+
+// The number of times -validate: was called on a ZTSQLiteTestSampledItem.
+static NSUInteger ZTSQLiteTestSampledItemValidationCount = 0;
+
+// An item of which only every third decoded one is validated.
+@interface ZTSQLiteTestSampledItem : ZTSQLiteTestItem
+
+@end
+
+@implementation ZTSQLiteTestSampledItem
+
++ (ZTSQLiteValidationPolicy)SQLiteValidationPolicy {
+    return ZTSQLiteValidationPolicySampled;
+}
+
++ (NSUInteger)SQLiteValidationSamplingInterval {
+    return 3;
+}
+
+- (BOOL)validate:(NSError *__autoreleasing *)error {
+    ZTSQLiteTestSampledItemValidationCount++;
+    return [super validate:error];
+}
+
+@end
+
+// An item uniqued by primary key.
+@interface ZTSQLiteTestSharedItem : ZTSQLiteTestItem
+
+@end
+
+@implementation ZTSQLiteTestSharedItem
+
++ (BOOL)usesSQLiteIdentityMap {
+    return YES;
+}
+
+@end
+
+// A row of the `measurements` table. Without validation methods, its
+// properties are set directly rather than through
+// +modelWithDictionary:error:.
+@interface ZTSQLiteTestMeasurement : MTLModel <ZTSQLiteSerializing>
+
+@property (nonatomic, assign) int64_t measurementID;
+@property (nonatomic, assign) double value;
+@property (nonatomic, assign) BOOL flagged;
+@property (nonatomic, copy) NSString *label;
+
+@end
+
+@implementation ZTSQLiteTestMeasurement
+
++ (NSDictionary *)SQLiteColumnNamesByPropertyKey {
+    return @{
+        @"measurementID": @"measurement_id",
+        @"value": @"value",
+        @"flagged": @"flagged",
+        @"label": @"label",
+    };
+}
+
++ (NSSet *)propertyKeysForPrimaryKeys {
+    return [NSSet setWithObject:@"measurementID"];
+}
+
+@end
+
+// A row of the `memberships` table, identified by two columns.
+@interface ZTSQLiteTestMembership : MTLModel <ZTSQLiteSerializing>
+
+@property (nonatomic, assign) int64_t groupID;
+@property (nonatomic, assign) int64_t memberID;
+
+@end
+
+@implementation ZTSQLiteTestMembership
+
++ (NSDictionary *)SQLiteColumnNamesByPropertyKey {
+    return @{
+        @"groupID": @"group_id",
+        @"memberID": @"member_id",
+    };
+}
+
++ (NSSet *)propertyKeysForPrimaryKeys {
+    return [NSSet setWithObjects:@"groupID", @"memberID", nil];
+}
+
+@end
+
+// A row of the `notes` table, whose tags are stored as comma-separated text
+// and decoded lazily.
+@interface ZTSQLiteTestNote : MTLModel <ZTSQLiteSerializing>
+
+@property (nonatomic, assign) int64_t noteID;
+@property (nonatomic, copy) NSArray *tags;
+
+@end
+
+@implementation ZTSQLiteTestNote
+
++ (NSDictionary *)SQLiteColumnNamesByPropertyKey {
+    return @{
+        @"noteID": @"note_id",
+        @"tags": @"tags",
+    };
+}
+
++ (NSSet *)propertyKeysForPrimaryKeys {
+    return [NSSet setWithObject:@"noteID"];
+}
+
++ (NSSet *)propertyKeysForLazySQLiteDecoding {
+    return [NSSet setWithObject:@"tags"];
+}
+
++ (NSValueTransformer *)tagsSQLiteColumnTransformer {
+    return [MTLValueTransformer transformerUsingForwardBlock:^id(NSString *text, BOOL *success, NSError *__autoreleasing *error) {
+        return [text componentsSeparatedByString:@","];
+    } reverseBlock:^id(NSArray *tags, BOOL *success, NSError *__autoreleasing *error) {
+        return [tags componentsJoinedByString:@","];
+    }];
+}
+
+@end
+
+#pragma mark Adapters
+
+// Inserts rows with the default values of all columns.
+@interface ZTSQLiteTestDefaultValuesAdapter : ZTSQLiteAdapter
+
+@end
+
+@implementation ZTSQLiteTestDefaultValuesAdapter
+
+- (NSSet *)insertablePropertyKeys:(NSSet *)propertyKeys forModel:(id<ZTSQLiteSerializing>)model {
+    return [NSSet set];
+}
+
+@end
+
+#if ZTSQLITE_INSTRUMENTATION
+
+// Counts the validations of ZTSQLiteTestItem in the atomic_ulong `context`.
+static void ZTSQLiteTestsCountItemValidation(Class modelClass, ZTSQLiteInstrumentationEvent event, uint64_t nanoseconds, void *context) {
+    if (modelClass == ZTSQLiteTestItem.class && event == ZTSQLiteInstrumentationEventValidation) {
+        atomic_fetch_add((atomic_ulong *)context, 1);
+    }
+}
+
+#endif
+
+#pragma mark -
 
 @interface ZTSQLiteAdapterTests : XCTestCase
 
 @end
 
-@implementation ZTSQLiteAdapterTests
+@implementation ZTSQLiteAdapterTests {
+    sqlite3 *_database;
+}
 
 - (void)setUp {
     [super setUp];
-    // Put setup code here. This method is called before the invocation of each test method in the class.
+
+    XCTAssertEqual(sqlite3_open(":memory:", &_database), SQLITE_OK);
+    [self executeSQL:@"CREATE TABLE items (item_id INTEGER PRIMARY KEY, name TEXT, quantity INTEGER)"];
+    [self executeSQL:@"CREATE TABLE memberships (group_id INTEGER, member_id INTEGER, PRIMARY KEY (group_id, member_id))"];
+    [self executeSQL:@"CREATE TABLE notes (note_id INTEGER PRIMARY KEY, tags TEXT)"];
+    [self executeSQL:@"CREATE TABLE measurements (measurement_id INTEGER PRIMARY KEY, value REAL, flagged INTEGER, label TEXT)"];
 }
 
 - (void)tearDown {
-    // Put teardown code here. This method is called after the invocation of each test method in the class.
+    sqlite3_close(_database);
+    _database = NULL;
+
     [super tearDown];
 }
 
-- (void)testExample {
-    // This is an example of a functional test case.
-    XCTAssert(YES, @"Pass");
+#pragma mark Helpers
+
+- (void)executeSQL:(NSString *)SQL {
+    XCTAssertEqual(sqlite3_exec(_database, SQL.UTF8String, NULL, NULL, NULL), SQLITE_OK, @"%s", sqlite3_errmsg(_database));
+}
+
+- (void)executeStatement:(NSString *)SQL withParameters:(NSArray *)parameters {
+    sqlite3_stmt *statement = [self prepareStatement:SQL];
+
+    NSError *error = nil;
+    XCTAssertTrue([ZTSQLiteAdapter bindParameters:parameters toStatement:statement error:&error], @"%@", error);
+    XCTAssertEqual(sqlite3_step(statement), SQLITE_DONE, @"%s", sqlite3_errmsg(_database));
+
+    sqlite3_finalize(statement);
+}
+
+- (sqlite3_stmt *)prepareStatement:(NSString *)SQL {
+    sqlite3_stmt *statement = NULL;
+    XCTAssertEqual(sqlite3_prepare_v2(_database, SQL.UTF8String, -1, &statement, NULL), SQLITE_OK, @"%s", sqlite3_errmsg(_database));
+
+    return statement;
+}
+
+// Returns the rows of a query as arrays of NSNumbers, NSStrings and NSNulls.
+- (NSArray *)rowsOfQuery:(NSString *)SQL {
+    sqlite3_stmt *statement = [self prepareStatement:SQL];
+    NSMutableArray *rows = [NSMutableArray array];
+
+    while (sqlite3_step(statement) == SQLITE_ROW) {
+        NSMutableArray *row = [NSMutableArray array];
+        for (int idx = 0; idx < sqlite3_column_count(statement); idx++) {
+            switch (sqlite3_column_type(statement, idx)) {
+                case SQLITE_INTEGER:
+                    [row addObject:@(sqlite3_column_int64(statement, idx))];
+                    break;
+                case SQLITE_FLOAT:
+                    [row addObject:@(sqlite3_column_double(statement, idx))];
+                    break;
+                case SQLITE_TEXT:
+                    [row addObject:@((const char *)sqlite3_column_text(statement, idx))];
+                    break;
+                default:
+                    [row addObject:NSNull.null];
+                    break;
+            }
+        }
+        [rows addObject:row];
+    }
+
+    sqlite3_finalize(statement);
+
+    return rows;
+}
+
+// Inserts items 1...count. Items whose ID is in `invalidItemIDs` get a negative
+// quantity.
+- (void)insertItemCount:(NSUInteger)count invalidItemIDs:(NSIndexSet *)invalidItemIDs {
+    [self executeSQL:@"BEGIN TRANSACTION"];
+
+    for (NSUInteger itemID = 1; itemID <= count; itemID++) {
+        int64_t quantity = [invalidItemIDs containsIndex:itemID] ? -(int64_t)itemID : (int64_t)itemID;
+        [self executeStatement:@"INSERT INTO items (item_id, name, quantity) VALUES (?, ?, ?)" withParameters:@[@(itemID), [NSString stringWithFormat:@"item %lu", (unsigned long)itemID], @(quantity)]];
+    }
+
+    [self executeSQL:@"COMMIT TRANSACTION"];
 }
 
-- (void)testPerformanceExample {
-    // This is an example of a performance test case.
-    [self measureBlock:^{
-        // Put the code you want to measure the time of here.
+- (NSArray *)resultDictionariesOfItemCount:(NSUInteger)count invalidItemIDs:(NSIndexSet *)invalidItemIDs {
+    NSMutableArray *resultDictionaries = [NSMutableArray arrayWithCapacity:count];
+
+    for (NSUInteger itemID = 1; itemID <= count; itemID++) {
+        int64_t quantity = [invalidItemIDs containsIndex:itemID] ? -(int64_t)itemID : (int64_t)itemID;
+        [resultDictionaries addObject:@{
+            @"item_id": @(itemID),
+            @"name": [NSString stringWithFormat:@"item %lu", (unsigned long)itemID],
+            @"quantity": @(quantity),
+        }];
+    }
+
+    return resultDictionaries;
+}
+
+- (NSString *)orderedItemsStatementWithAdapter:(ZTSQLiteAdapter *)adapter {
+    return [NSString stringWithFormat:@"SELECT %@ FROM items ORDER BY item_id", [adapter columnListForPropertyKeys:nil]];
+}
+
+- (ZTSQLiteTestItem *)itemWithID:(int64_t)itemID propertyKeys:(NSSet *)propertyKeys adapter:(ZTSQLiteAdapter *)adapter {
+    NSString *SQL = [adapter statementSelectingPropertyKeys:propertyKeys fromTable:@"items" where:@"item_id = ?"];
+    sqlite3_stmt *statement = [self prepareStatement:SQL];
+    sqlite3_bind_int64(statement, 1, itemID);
+    XCTAssertEqual(sqlite3_step(statement), SQLITE_ROW);
+
+    NSError *error = nil;
+    ZTSQLiteTestItem *item = [adapter modelFromStatement:statement propertyKeys:propertyKeys error:&error];
+    XCTAssertNotNil(item, @"%@", error);
+
+    sqlite3_finalize(statement);
+
+    return item;
+}
+
+// Inserts note 1 tagged "a,b" and decodes it.
+- (ZTSQLiteTestNote *)decodedNoteWithAdapter:(ZTSQLiteAdapter *)adapter {
+    [self executeSQL:@"INSERT INTO notes (note_id, tags) VALUES (1, 'a,b')"];
+
+    sqlite3_stmt *statement = [self prepareStatement:[adapter statementSelectingFromTable:@"notes" where:@"note_id = 1"]];
+    XCTAssertEqual(sqlite3_step(statement), SQLITE_ROW);
+
+    NSError *error = nil;
+    ZTSQLiteTestNote *note = [adapter modelFromStatement:statement propertyKeys:nil error:&error];
+    XCTAssertNotNil(note, @"%@", error);
+
+    sqlite3_finalize(statement);
+
+    return note;
+}
+
+// Returns a new item that was not decoded.
+- (ZTSQLiteTestItem *)itemWithID:(int64_t)itemID name:(NSString *)name {
+    ZTSQLiteTestItem *item = [[ZTSQLiteTestItem alloc] init];
+    item.itemID = itemID;
+    item.name = name;
+    item.quantity = itemID;
+    return item;
+}
+
+- (void)executeStatements:(NSArray *)statements withParameterArrays:(NSArray *)parameterArrays {
+    XCTAssertEqual(statements.count, parameterArrays.count);
+
+    [statements enumerateObjectsUsingBlock:^(NSString *statement, NSUInteger idx, BOOL *stop) {
+        [self executeStatement:statement withParameters:parameterArrays[idx]];
     }];
 }
 
+#pragma mark Statements
+
+- (void)testEqualStatementsAreTheSameInstance {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+
+    NSString *statement = nil;
+    NSString *otherStatement = nil;
+    NSError *error = nil;
+    XCTAssertNotNil([adapter parameterDictionaryFromModel:[self itemWithID:1 name:@"a"] insertingIntoTable:@"items" statement:&statement error:&error], @"%@", error);
+    XCTAssertNotNil([adapter parameterDictionaryFromModel:[self itemWithID:2 name:@"b"] insertingIntoTable:@"items" statement:&otherStatement error:&error], @"%@", error);
+    XCTAssertEqual(statement, otherStatement);
+
+    XCTAssertEqual([adapter statementSelectingFromTable:@"items" where:nil], [adapter statementSelectingFromTable:@"items" where:nil]);
+
+    // Statements of other tables are cached separately.
+    XCTAssertNotNil([adapter parameterDictionaryFromModel:[self itemWithID:1 name:@"a"] insertingIntoTable:@"archived_items" statement:&otherStatement error:&error], @"%@", error);
+    XCTAssertNotEqualObjects(statement, otherStatement);
+}
+
+- (void)testPositionalParametersMatchPlaceholderOrder {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+    ZTSQLiteTestItem *item = [self itemWithID:7 name:@"seven"];
+
+    NSString *statement = nil;
+    NSError *error = nil;
+    NSArray *parameters = [adapter parameterArrayFromModel:item insertingIntoTable:@"items" statement:&statement error:&error];
+    XCTAssertNotNil(parameters, @"%@", error);
+    XCTAssertEqual([statement componentsSeparatedByString:@"?"].count - 1, parameters.count);
+    [self executeStatement:statement withParameters:parameters];
+
+    item.name = @"renamed";
+    item.quantity = 70;
+    parameters = [adapter parameterArrayFromModel:item updatingInTable:@"items" statement:&statement error:&error];
+    XCTAssertNotNil(parameters, @"%@", error);
+    XCTAssertEqual([statement componentsSeparatedByString:@"?"].count - 1, parameters.count);
+    [self executeStatement:statement withParameters:parameters];
+
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT item_id, name, quantity FROM items"], (@[@[@7, @"renamed", @70]]));
+
+    parameters = [adapter parameterArrayFromModel:item deletingFromTable:@"items" statement:&statement error:&error];
+    XCTAssertEqualObjects(parameters, @[@7], @"%@", error);
+    [self executeStatement:statement withParameters:parameters];
+
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT COUNT(*) FROM items"], @[@[@0]]);
+}
+
+#pragma mark Inserts
+
+- (void)testBatchInsertWithoutColumnsUsesDefaultValues {
+    NSArray *items = @[[self itemWithID:1 name:@"a"], [self itemWithID:2 name:@"b"], [self itemWithID:3 name:@"c"]];
+
+    NSArray *statements = nil;
+    NSError *error = nil;
+    NSArray *parameterArrays = [ZTSQLiteTestDefaultValuesAdapter parameterArraysFromModels:items insertingIntoTable:@"items" statements:&statements error:&error];
+    XCTAssertEqualObjects(parameterArrays, (@[@[], @[], @[]]), @"%@", error);
+    XCTAssertEqualObjects(statements.firstObject, @"INSERT INTO items DEFAULT VALUES;");
+
+    [self executeStatements:statements withParameterArrays:parameterArrays];
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT COUNT(*) FROM items WHERE name IS NULL"], @[@[@3]]);
+}
+
+#pragma mark Bulk writing
+
+- (void)testBulkWriterCommitsEveryCommitSizeRows {
+    ZTSQLiteBulkWriter *writer = [[ZTSQLiteBulkWriter alloc] initWithDatabase:_database tableName:@"items"];
+    writer.commitSize = 1000;
+    writer.encodingBatchSize = 500;
+
+    NSMutableArray *progress = [NSMutableArray array];
+    writer.progressHandler = ^(NSUInteger rowsWritten, double rowsPerSecond) {
+        [progress addObject:@(rowsWritten)];
+    };
+
+    NSError *error = nil;
+    XCTAssertTrue([writer writeModels:[self unsavedItemsWithIDs:NSMakeRange(1, 2500)] error:&error], @"%@", error);
+    XCTAssertEqual(writer.rowsWritten, (NSUInteger)2500);
+    XCTAssertEqualObjects(progress, (@[@1000, @2000, @2500]));
+    XCTAssertNotEqual(sqlite3_get_autocommit(_database), 0);
+
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT COUNT(*), MIN(item_id), MAX(item_id) FROM items"], (@[@[@2500, @1, @2500]]));
+}
+
+- (void)testBulkWriterRollsBackFailedTransaction {
+    [self executeSQL:@"INSERT INTO items (item_id, name, quantity) VALUES (1500, 'existing', 0)"];
+
+    ZTSQLiteBulkWriter *writer = [[ZTSQLiteBulkWriter alloc] initWithDatabase:_database tableName:@"items"];
+    writer.commitSize = 1000;
+    writer.encodingBatchSize = 500;
+
+    NSError *error = nil;
+    XCTAssertFalse([writer writeModels:[self unsavedItemsWithIDs:NSMakeRange(1, 2000)] error:&error]);
+    XCTAssertEqualObjects(error.domain, ZTSQLiteAdapterErrorDomain);
+    XCTAssertEqual(error.code, ZTSQLiteAdapterErrorStatementFailed);
+    XCTAssertNotEqual(sqlite3_get_autocommit(_database), 0);
+
+    // The first transaction was committed before the conflicting row.
+    XCTAssertEqual(writer.rowsWritten, (NSUInteger)1000);
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT COUNT(*) FROM items"], @[@[@1001]]);
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT name FROM items WHERE item_id = 1500"], @[@[@"existing"]]);
+}
+
+#pragma mark Upserts
+
+- (void)testUpsertInsertsAndOverwritesRow {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+    ZTSQLiteTestItem *item = [self itemWithID:1 name:@"item 1"];
+
+    NSString *statement = nil;
+    NSError *error = nil;
+    NSArray *parameters = [adapter parameterArrayFromModel:item upsertingIntoTable:@"items" statement:&statement error:&error];
+    XCTAssertNotNil(parameters, @"%@", error);
+    [self executeStatement:statement withParameters:parameters];
+
+    item.name = @"renamed";
+    NSString *otherStatement = nil;
+    parameters = [adapter parameterArrayFromModel:item upsertingIntoTable:@"items" statement:&otherStatement error:&error];
+    XCTAssertNotNil(parameters, @"%@", error);
+    XCTAssertEqual(otherStatement, statement);
+    [self executeStatement:otherStatement withParameters:parameters];
+
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT item_id, name, quantity FROM items"], (@[@[@1, @"renamed", @1]]));
+    XCTAssertEqualObjects([self itemWithID:1 propertyKeys:nil adapter:adapter], item);
+}
+
+- (void)testBatchUpsertInsertsAndOverwritesRows {
+    [self insertItemCount:3 invalidItemIDs:nil];
+
+    NSArray *items = @[[self itemWithID:2 name:@"renamed"], [self itemWithID:4 name:@"item 4"]];
+
+    NSArray *statements = nil;
+    NSError *error = nil;
+    NSArray *parameterArrays = [ZTSQLiteAdapter parameterArraysFromModels:items upsertingIntoTable:@"items" statements:&statements error:&error];
+    XCTAssertNotNil(parameterArrays, @"%@", error);
+    XCTAssertEqual(statements.count, (NSUInteger)1);
+
+    [self executeStatements:statements withParameterArrays:parameterArrays];
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT item_id, name FROM items ORDER BY item_id"], (@[@[@1, @"item 1"], @[@2, @"renamed"], @[@3, @"item 3"], @[@4, @"item 4"]]));
+}
+
+- (NSArray *)unsavedItemsWithIDs:(NSRange)itemIDs {
+    NSMutableArray *items = [NSMutableArray arrayWithCapacity:itemIDs.length];
+    for (NSUInteger itemID = itemIDs.location; itemID < NSMaxRange(itemIDs); itemID++) {
+        [items addObject:[self itemWithID:(int64_t)itemID name:[NSString stringWithFormat:@"item %lu", (unsigned long)itemID]]];
+    }
+    return items;
+}
+
+#pragma mark Updates
+
+- (void)testUpdateRevertingChangeIsNotSkipped {
+    [self insertItemCount:1 invalidItemIDs:nil];
+
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+    ZTSQLiteTestItem *item = [self itemWithID:1 propertyKeys:nil adapter:adapter];
+    XCTAssertEqualObjects(item.name, @"item 1");
+
+    NSString *statement = nil;
+    NSError *error = nil;
+    NSArray *parameters = [adapter parameterArrayFromModel:item updatingInTable:@"items" statement:&statement error:&error];
+    XCTAssertEqualObjects(parameters, @[]);
+    XCTAssertNil(statement);
+
+    item.name = @"renamed";
+    parameters = [adapter parameterArrayFromModel:item updatingInTable:@"items" statement:&statement error:&error];
+    XCTAssertNotNil(statement, @"%@", error);
+
+    // Serializing alone doesn't change what the row is assumed to hold.
+    statement = nil;
+    parameters = [adapter parameterArrayFromModel:item updatingInTable:@"items" statement:&statement error:&error];
+    XCTAssertNotNil(statement, @"%@", error);
+    [self executeStatement:statement withParameters:parameters];
+    XCTAssertTrue([adapter didPersistModel:item error:&error], @"%@", error);
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT name FROM items"], @[@[@"renamed"]]);
+
+    // The row now holds the new name, so reverting to the decoded one must
+    // update it again.
+    item.name = @"item 1";
+    statement = nil;
+    parameters = [adapter parameterArrayFromModel:item updatingInTable:@"items" statement:&statement error:&error];
+    XCTAssertNotNil(statement, @"%@", error);
+    [self executeStatement:statement withParameters:parameters];
+    XCTAssertTrue([adapter didPersistModel:item error:&error], @"%@", error);
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT name FROM items"], @[@[@"item 1"]]);
+
+    parameters = [adapter parameterArrayFromModel:item updatingInTable:@"items" statement:&statement error:&error];
+    XCTAssertEqualObjects(parameters, @[]);
+    XCTAssertNil(statement);
+}
+
+- (void)testUpdateOfProjectedModelOnlyWritesDecodedColumns {
+    [self insertItemCount:1 invalidItemIDs:nil];
+
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+    ZTSQLiteTestItem *item = [self itemWithID:1 propertyKeys:[NSSet setWithObjects:@"itemID", @"name", nil] adapter:adapter];
+    XCTAssertEqual(item.quantity, (int64_t)0);
+
+    item.name = @"renamed";
+
+    NSString *statement = nil;
+    NSError *error = nil;
+    NSArray *parameters = [adapter parameterArrayFromModel:item updatingInTable:@"items" statement:&statement error:&error];
+    XCTAssertNotNil(parameters, @"%@", error);
+    XCTAssertEqual([statement rangeOfString:@"quantity"].location, NSNotFound, @"%@", statement);
+
+    [self executeStatement:statement withParameters:parameters];
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT item_id, name, quantity FROM items"], (@[@[@1, @"renamed", @1]]));
+}
+
+- (void)testUpdateOfModelWithoutDecodedPrimaryKeyFails {
+    [self insertItemCount:1 invalidItemIDs:nil];
+
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+    ZTSQLiteTestItem *item = [self itemWithID:1 propertyKeys:[NSSet setWithObject:@"name"] adapter:adapter];
+    item.name = @"renamed";
+
+    NSString *statement = nil;
+    NSError *error = nil;
+    XCTAssertNil([adapter parameterArrayFromModel:item updatingInTable:@"items" statement:&statement error:&error]);
+    XCTAssertEqualObjects(error.domain, ZTSQLiteAdapterErrorDomain);
+    XCTAssertEqual(error.code, ZTSQLiteAdapterErrorPrimaryKeyNotDecoded);
+
+    error = nil;
+    XCTAssertNil([adapter parameterArrayFromModel:item deletingFromTable:@"items" statement:&statement error:&error]);
+    XCTAssertEqual(error.code, ZTSQLiteAdapterErrorPrimaryKeyNotDecoded);
+
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT name FROM items"], @[@[@"item 1"]]);
+}
+
+#pragma mark Direct assignment
+
+- (void)testDirectlyAssignedModelEqualsModelWithDictionary {
+    [self executeSQL:@"INSERT INTO measurements (measurement_id, value, flagged, label) VALUES (1, 2.5, 1, 'one'), (2, -0.125, 0, NULL)"];
+
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestMeasurement.class];
+    sqlite3_stmt *statement = [self prepareStatement:[NSString stringWithFormat:@"SELECT %@ FROM measurements ORDER BY measurement_id", [adapter columnListForPropertyKeys:nil]]];
+
+    NSError *error = nil;
+    NSArray *measurements = [adapter modelsFromStatement:statement errorsByIndex:NULL error:&error];
+    XCTAssertEqual(measurements.count, (NSUInteger)2, @"%@", error);
+
+    sqlite3_finalize(statement);
+
+    ZTSQLiteTestMeasurement *expected = [ZTSQLiteTestMeasurement modelWithDictionary:@{ @"measurementID": @1, @"value": @2.5, @"flagged": @YES, @"label": @"one" } error:&error];
+    XCTAssertEqualObjects(measurements[0], expected);
+
+    expected = [ZTSQLiteTestMeasurement modelWithDictionary:@{ @"measurementID": @2, @"value": @-0.125, @"flagged": @NO } error:&error];
+    XCTAssertEqualObjects(measurements[1], expected);
+}
+
+#pragma mark Scalars
+
+- (void)testScalarPropertiesRoundTripThroughBoundStatement {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestMeasurement.class];
+
+    ZTSQLiteTestMeasurement *measurement = [[ZTSQLiteTestMeasurement alloc] init];
+    measurement.measurementID = INT64_MAX;
+    measurement.value = 0.1;
+    measurement.flagged = YES;
+    measurement.label = @"max";
+
+    ZTSQLiteTestMeasurement *otherMeasurement = [[ZTSQLiteTestMeasurement alloc] init];
+    otherMeasurement.measurementID = INT64_MIN;
+    otherMeasurement.value = -1e300;
+
+    NSString *SQL = nil;
+    NSError *error = nil;
+    XCTAssertNotNil([adapter parameterDictionaryFromModel:measurement insertingIntoTable:@"measurements" statement:&SQL error:&error], @"%@", error);
+
+    // One prepared statement is reset and bound again for every model.
+    sqlite3_stmt *statement = [self prepareStatement:SQL];
+    for (ZTSQLiteTestMeasurement *model in @[measurement, otherMeasurement]) {
+        XCTAssertTrue([adapter bindParametersOfStatement:statement fromModel:model error:&error], @"%@", error);
+        XCTAssertEqual(sqlite3_step(statement), SQLITE_DONE, @"%s", sqlite3_errmsg(_database));
+        sqlite3_reset(statement);
+    }
+    sqlite3_finalize(statement);
+
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT typeof(measurement_id), typeof(value), typeof(flagged), value FROM measurements ORDER BY measurement_id DESC"],
+                          (@[@[@"integer", @"real", @"integer", @0.1], @[@"integer", @"real", @"integer", @-1e300]]));
+
+    statement = [self prepareStatement:[NSString stringWithFormat:@"SELECT %@ FROM measurements ORDER BY measurement_id DESC", [adapter columnListForPropertyKeys:nil]]];
+    NSArray *measurements = [adapter modelsFromStatement:statement errorsByIndex:NULL error:&error];
+    sqlite3_finalize(statement);
+
+    XCTAssertEqualObjects(measurements, (@[measurement, otherMeasurement]), @"%@", error);
+}
+
+#pragma mark Validation
+
+- (void)testSampledValidationValidatesEveryIntervalModels {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestSampledItem.class];
+    NSArray *resultDictionaries = [self resultDictionariesOfItemCount:10 invalidItemIDs:nil];
+
+    ZTSQLiteTestSampledItemValidationCount = 0;
+
+    NSError *error = nil;
+    NSArray *items = [adapter modelsFromResultDictionaries:resultDictionaries errorsByIndex:NULL error:&error];
+    XCTAssertEqual(items.count, (NSUInteger)10, @"%@", error);
+
+    // The 1st, 4th, 7th and 10th models.
+    XCTAssertEqual(ZTSQLiteTestSampledItemValidationCount, (NSUInteger)4);
+}
+
+#pragma mark Lazy decoding
+
+- (void)testUnreadLazyPropertySerializesColumnValue {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestNote.class];
+    ZTSQLiteTestNote *note = [self decodedNoteWithAdapter:adapter];
+
+    NSError *error = nil;
+    NSDictionary *parameters = [adapter parameterDictionaryFromModel:note insertingIntoTable:@"notes" statement:NULL error:&error];
+    XCTAssertEqualObjects(parameters[@"tags"], @"a,b", @"%@", error);
+
+    XCTAssertEqualObjects(note.tags, (@[@"a", @"b"]));
+}
+
+- (void)testSettingLazyPropertyBeforeReadingKeepsValue {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestNote.class];
+    ZTSQLiteTestNote *note = [self decodedNoteWithAdapter:adapter];
+
+    note.tags = @[@"c"];
+    XCTAssertEqualObjects(note.tags, @[@"c"]);
+}
+
+- (void)testSettingLazyPropertyBeforeReadingSerializesValue {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestNote.class];
+    ZTSQLiteTestNote *note = [self decodedNoteWithAdapter:adapter];
+
+    note.tags = @[@"c"];
+
+    NSError *error = nil;
+    NSDictionary *parameters = [adapter parameterDictionaryFromModel:note insertingIntoTable:@"notes" statement:NULL error:&error];
+    XCTAssertEqualObjects(parameters[@"tags"], @"c", @"%@", error);
+}
+
+- (void)testReadLazyPropertySerializesPropertyValue {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestNote.class];
+    ZTSQLiteTestNote *note = [self decodedNoteWithAdapter:adapter];
+
+    XCTAssertEqualObjects(note.tags, (@[@"a", @"b"]));
+    note.tags = @[@"b", @"a"];
+
+    NSError *error = nil;
+    NSDictionary *parameters = [adapter parameterDictionaryFromModel:note insertingIntoTable:@"notes" statement:NULL error:&error];
+    XCTAssertEqualObjects(parameters[@"tags"], @"b,a", @"%@", error);
+}
+
+#pragma mark Identity map
+
+- (void)testIdentityMapReturnsResidentModel {
+    [self insertItemCount:2 invalidItemIDs:nil];
+
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestSharedItem.class];
+    ZTSQLiteTestItem *item = [self itemWithID:1 propertyKeys:nil adapter:adapter];
+    XCTAssertTrue([item isKindOfClass:ZTSQLiteTestSharedItem.class]);
+
+    XCTAssertEqual([self itemWithID:1 propertyKeys:nil adapter:adapter], item);
+    XCTAssertNotEqual([self itemWithID:2 propertyKeys:nil adapter:adapter], item);
+}
+
+- (void)testIdentityMapDecodesChangedRow {
+    [self insertItemCount:1 invalidItemIDs:nil];
+
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestSharedItem.class];
+    ZTSQLiteTestItem *item = [self itemWithID:1 propertyKeys:nil adapter:adapter];
+
+    [self executeSQL:@"UPDATE items SET name = 'renamed' WHERE item_id = 1"];
+
+    ZTSQLiteTestItem *changedItem = [self itemWithID:1 propertyKeys:nil adapter:adapter];
+    XCTAssertNotEqual(changedItem, item);
+    XCTAssertEqualObjects(changedItem.name, @"renamed");
+    XCTAssertEqualObjects(item.name, @"item 1");
+
+    // The newer model replaced the old one.
+    XCTAssertEqual([self itemWithID:1 propertyKeys:nil adapter:adapter], changedItem);
+}
+
+- (void)testIdentityMapDoesNotShareProjectedModels {
+    [self insertItemCount:1 invalidItemIDs:nil];
+
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestSharedItem.class];
+    NSSet *propertyKeys = [NSSet setWithObjects:@"itemID", @"name", nil];
+    ZTSQLiteTestItem *item = [self itemWithID:1 propertyKeys:propertyKeys adapter:adapter];
+
+    XCTAssertNotEqual([self itemWithID:1 propertyKeys:propertyKeys adapter:adapter], item);
+}
+
+#pragma mark Deletes
+
+- (void)testBatchDeleteWithCompositePrimaryKey {
+    NSMutableArray *deletedMemberships = [NSMutableArray array];
+
+    [self executeSQL:@"BEGIN TRANSACTION"];
+    for (int64_t groupID = 1; groupID <= 20; groupID++) {
+        for (int64_t memberID = 1; memberID <= 50; memberID++) {
+            [self executeStatement:@"INSERT INTO memberships (group_id, member_id) VALUES (?, ?)" withParameters:@[@(groupID), @(memberID)]];
+
+            // Rows sharing a group or member with a deleted row must survive.
+            if (groupID % 2 == 0 && memberID % 2 == 1) {
+                ZTSQLiteTestMembership *membership = [[ZTSQLiteTestMembership alloc] init];
+                membership.groupID = groupID;
+                membership.memberID = memberID;
+                [deletedMemberships addObject:membership];
+            }
+        }
+    }
+    [self executeSQL:@"COMMIT TRANSACTION"];
+
+    NSArray *statements = nil;
+    NSError *error = nil;
+    NSArray *parameterArrays = [ZTSQLiteAdapter parameterArraysFromModels:deletedMemberships deletingFromTable:@"memberships" statements:&statements error:&error];
+    XCTAssertNotNil(parameterArrays, @"%@", error);
+    XCTAssertEqual(statements.count, parameterArrays.count);
+
+    [statements enumerateObjectsUsingBlock:^(NSString *statement, NSUInteger idx, BOOL *stop) {
+        [self executeStatement:statement withParameters:parameterArrays[idx]];
+    }];
+
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT COUNT(*) FROM memberships"], @[@[@(1000 - deletedMemberships.count)]]);
+    XCTAssertEqualObjects([self rowsOfQuery:@"SELECT COUNT(*) FROM memberships WHERE group_id % 2 = 0 AND member_id % 2 = 1"], @[@[@0]]);
+}
+
+#pragma mark Concurrent decoding
+
+- (void)testConcurrentDecodingPreservesOrder {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+    NSArray *resultDictionaries = [self resultDictionariesOfItemCount:2000 invalidItemIDs:nil];
+
+    NSDictionary *errorsByIndex = nil;
+    NSError *error = nil;
+    NSArray *items = [adapter modelsConcurrentlyFromResultDictionaries:resultDictionaries propertyKeys:nil errorsByIndex:&errorsByIndex error:&error];
+    XCTAssertEqual(items.count, resultDictionaries.count, @"%@", error);
+    XCTAssertNil(errorsByIndex);
+
+    [items enumerateObjectsUsingBlock:^(ZTSQLiteTestItem *item, NSUInteger idx, BOOL *stop) {
+        XCTAssertEqual(item.itemID, (int64_t)idx + 1);
+    }];
+}
+
+- (void)testConcurrentDecodingReportsErrorsByIndex {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+    NSMutableIndexSet *invalidItemIDs = [NSMutableIndexSet indexSetWithIndex:300];
+    [invalidItemIDs addIndex:1700];
+    NSArray *resultDictionaries = [self resultDictionariesOfItemCount:2000 invalidItemIDs:invalidItemIDs];
+
+    NSDictionary *errorsByIndex = nil;
+    NSError *error = nil;
+    NSArray *items = [adapter modelsConcurrentlyFromResultDictionaries:resultDictionaries propertyKeys:nil errorsByIndex:&errorsByIndex error:&error];
+    XCTAssertEqual(items.count, resultDictionaries.count - invalidItemIDs.count, @"%@", error);
+    XCTAssertEqualObjects([NSSet setWithArray:errorsByIndex.allKeys], ([NSSet setWithObjects:@299, @1699, nil]));
+    XCTAssertEqual([errorsByIndex[@1699] code], (NSInteger)1700);
+
+    int64_t previousItemID = 0;
+    for (ZTSQLiteTestItem *item in items) {
+        XCTAssertGreaterThan(item.itemID, previousItemID);
+        XCTAssertFalse([invalidItemIDs containsIndex:(NSUInteger)item.itemID]);
+        previousItemID = item.itemID;
+    }
+}
+
+- (void)testConcurrentDecodingReportsFirstError {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+    NSMutableIndexSet *invalidItemIDs = [NSMutableIndexSet indexSetWithIndex:1200];
+    [invalidItemIDs addIndex:1900];
+    NSArray *resultDictionaries = [self resultDictionariesOfItemCount:2000 invalidItemIDs:invalidItemIDs];
+
+    NSError *error = nil;
+    XCTAssertNil([adapter modelsConcurrentlyFromResultDictionaries:resultDictionaries propertyKeys:nil errorsByIndex:NULL error:&error]);
+    XCTAssertEqualObjects(error.domain, ZTSQLiteTestsErrorDomain);
+    XCTAssertEqual(error.code, (NSInteger)1200);
+}
+
+#pragma mark Streaming decoding
+
+- (void)testStreamingDecodingPreservesOrder {
+    [self insertItemCount:3000 invalidItemIDs:nil];
+
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+    sqlite3_stmt *statement = [self prepareStatement:[self orderedItemsStatementWithAdapter:adapter]];
+
+    __block NSUInteger rowCount = 0;
+    NSError *error = nil;
+    BOOL success = [adapter enumerateModelsFromStatement:statement propertyKeys:nil usingBlock:^(ZTSQLiteTestItem *item, NSUInteger idx, BOOL *stop) {
+        XCTAssertEqual(idx, rowCount);
+        XCTAssertEqual(item.itemID, (int64_t)idx + 1);
+        rowCount++;
+    } error:&error];
+
+    XCTAssertTrue(success, @"%@", error);
+    XCTAssertEqual(rowCount, (NSUInteger)3000);
+
+    sqlite3_finalize(statement);
+}
+
+- (void)testStreamingDecodingStopsAtFirstError {
+    [self insertItemCount:3000 invalidItemIDs:[NSIndexSet indexSetWithIndex:2001]];
+
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+    sqlite3_stmt *statement = [self prepareStatement:[self orderedItemsStatementWithAdapter:adapter]];
+
+    __block NSUInteger rowCount = 0;
+    NSError *error = nil;
+    BOOL success = [adapter enumerateModelsFromStatement:statement propertyKeys:nil usingBlock:^(ZTSQLiteTestItem *item, NSUInteger idx, BOOL *stop) {
+        XCTAssertEqual(idx, rowCount);
+        rowCount++;
+    } error:&error];
+
+    XCTAssertFalse(success);
+    XCTAssertEqualObjects(error.domain, ZTSQLiteTestsErrorDomain);
+    XCTAssertEqual(error.code, (NSInteger)2001);
+    XCTAssertEqual(rowCount, (NSUInteger)2000);
+
+    sqlite3_finalize(statement);
+}
+
+- (void)testStreamingDecodingStopsWhenBlockStops {
+    [self insertItemCount:3000 invalidItemIDs:nil];
+
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+    sqlite3_stmt *statement = [self prepareStatement:[self orderedItemsStatementWithAdapter:adapter]];
+
+    __block NSUInteger rowCount = 0;
+    NSError *error = nil;
+    BOOL success = [adapter enumerateModelsFromStatement:statement propertyKeys:nil usingBlock:^(ZTSQLiteTestItem *item, NSUInteger idx, BOOL *stop) {
+        rowCount++;
+        *stop = idx == 99;
+    } error:&error];
+
+    XCTAssertTrue(success, @"%@", error);
+    XCTAssertEqual(rowCount, (NSUInteger)100);
+
+    sqlite3_finalize(statement);
+}
+
+#if ZTSQLITE_INSTRUMENTATION
+
+#pragma mark Instrumentation
+
+- (void)testInstrumentationRecordsFailedValidations {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestNamedItem.class];
+    NSMutableArray *resultDictionaries = [[self resultDictionariesOfItemCount:10 invalidItemIDs:nil] mutableCopy];
+    resultDictionaries[3] = @{ @"item_id": @4, @"name": @"", @"quantity": @4 };
+
+    [adapter resetInstrumentationStatistics];
+    [ZTSQLiteAdapter setRecordsInstrumentation:YES];
+
+    NSDictionary *errorsByIndex = nil;
+    NSArray *items = [adapter modelsFromResultDictionaries:resultDictionaries errorsByIndex:&errorsByIndex error:NULL];
+
+    [ZTSQLiteAdapter setRecordsInstrumentation:NO];
+
+    XCTAssertEqual(items.count, (NSUInteger)9);
+    XCTAssertEqual(errorsByIndex.count, (NSUInteger)1);
+
+    ZTSQLiteInstrumentationStatistics validation = [adapter instrumentationStatisticsForEvent:ZTSQLiteInstrumentationEventValidation];
+    XCTAssertEqual(validation.count, (uint64_t)10);
+
+    uint64_t histogramCount = 0;
+    for (NSUInteger bucket = 0; bucket < ZTSQLiteInstrumentationHistogramBucketCount; bucket++) {
+        histogramCount += validation.histogram[bucket];
+    }
+    XCTAssertEqual(histogramCount, (uint64_t)10);
+
+    // Nothing is recorded once recording stops.
+    [adapter modelsFromResultDictionaries:resultDictionaries errorsByIndex:&errorsByIndex error:NULL];
+    XCTAssertEqual([adapter instrumentationStatisticsForEvent:ZTSQLiteInstrumentationEventValidation].count, (uint64_t)10);
+}
+
+- (void)testInstrumentationCallbackReceivesEventsUntilCleared {
+    ZTSQLiteAdapter *adapter = [ZTSQLiteAdapter adapterForModelClass:ZTSQLiteTestItem.class];
+    NSArray *resultDictionaries = [self resultDictionariesOfItemCount:5 invalidItemIDs:nil];
+
+    atomic_ulong validationCount = 0;
+    [ZTSQLiteAdapter setInstrumentationCallback:ZTSQLiteTestsCountItemValidation context:&validationCount];
+    XCTAssertEqual([adapter modelsFromResultDictionaries:resultDictionaries errorsByIndex:NULL error:NULL].count, (NSUInteger)5);
+
+    // Replacing the callback must keep reporting to the new one.
+    [ZTSQLiteAdapter setInstrumentationCallback:ZTSQLiteTestsCountItemValidation context:&validationCount];
+    XCTAssertEqual([adapter modelsFromResultDictionaries:resultDictionaries errorsByIndex:NULL error:NULL].count, (NSUInteger)5);
+
+    [ZTSQLiteAdapter setInstrumentationCallback:NULL context:NULL];
+    XCTAssertEqual([adapter modelsFromResultDictionaries:resultDictionaries errorsByIndex:NULL error:NULL].count, (NSUInteger)5);
+
+    XCTAssertEqual(atomic_load(&validationCount), (unsigned long)10);
+}
+
+#endif
+
 @end